@@ -13,6 +13,17 @@ void PrintUsage(std::ostream &stream = std::cerr) {
     stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
 }
 
+void PrintPrecomputeStats(const router::PrecomputeStats &stats,
+                          std::ostream &stream = std::cerr) {
+    stream << "router precompute: "sv << stats.time.count() << " ms"sv;
+    if (stats.sequential_time) {
+        stream << ", sequential: "sv << stats.sequential_time->count() << " ms"sv
+               << ", speedup: "sv << stats.sequential_time->count() / stats.time.count()
+               << ", bit-identical: "sv << (stats.identical ? "yes"sv : "no"sv);
+    }
+    stream << '\n';
+}
+
 int main(int argc, char *argv[]) {
     if (argc != 2) {
         PrintUsage();
@@ -31,6 +42,10 @@ int main(int argc, char *argv[]) {
 
         renderer::MapRenderer map_renderer(reader.GetRendererSettings(), db.GetBuses());
         router::TransportRouter router(db, reader.GetRoutingSettings());
+        PrintPrecomputeStats(router.GetPrecomputeStats());
+        if (!router.GetPrecomputeStats().identical) {
+            return 1;
+        }
         serialize::Serializer serializer(reader.GetSerializationSettings());
 
         serializer.Serialize(db, map_renderer, router);
@@ -51,8 +66,17 @@ int main(int argc, char *argv[]) {
 
         tc::TransportCatalogue catalogue = std::move(serializer.GetTransportCatalogue());
         router::TransportRouter router(
-            catalogue, serializer.GetRouterVertexes(), serializer.GetRouterEdgesInfo(),
-            serializer.GetRouterGraph(), serializer.GetRouterInternalData());
+            catalogue, serializer.GetRoutingSettings(), serializer.GetRouterVertexes(),
+            serializer.GetRouterEdgesInfo(), serializer.GetRouterBusEdges(),
+            serializer.GetRouterGraph(), serializer.GetRouterComponents(),
+            serializer.GetRouterData(), serializer.GetProfilesData());
+        if (reader.HasRoutingSettings()) {
+            router.SetRoutingSettings(reader.GetRoutingSettings(router.GetSettings()));
+            PrintPrecomputeStats(router.GetPrecomputeStats());
+            if (!router.GetPrecomputeStats().identical) {
+                return 1;
+            }
+        }
         renderer::MapRenderer map_renderer(serializer.GetRendererSettings(),
                                            catalogue.GetBuses());
 
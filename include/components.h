@@ -0,0 +1,181 @@
+#pragma once
+
+#include "csr_graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Strongly and weakly connected components of a graph. Strong components are numbered
+// in reverse topological order of the condensation: an arc between two of them always
+// goes to a smaller number. So a route from one vertex to another needs the same weak
+// component and a strong component number not below that of the target; when either
+// fails there is no route, which is answered without a search. Only the topology
+// matters, the index survives any change of edge weights.
+class ComponentIndex {
+  public:
+    struct Data {
+        std::vector<uint32_t> strong;
+        std::vector<uint32_t> weak;
+    };
+
+  public:
+    ComponentIndex() = default;
+    template <typename Weight>
+    explicit ComponentIndex(const CsrGraph<Weight> &graph);
+    explicit ComponentIndex(Data data);
+
+    // False only when there is surely no route; true when from and to are strongly
+    // connected, and otherwise a search has to tell.
+    bool MayReach(VertexId from, VertexId to) const {
+        return data_.weak[from] == data_.weak[to] && data_.strong[from] >= data_.strong[to];
+    }
+    bool IsStronglyConnected(VertexId from, VertexId to) const {
+        return data_.strong[from] == data_.strong[to];
+    }
+
+    size_t GetVertexCount() const {
+        return data_.strong.size();
+    }
+    size_t GetWeakCount() const {
+        return weak_count_;
+    }
+    size_t GetStrongCount() const {
+        return strong_count_;
+    }
+    const Data &GetData() const {
+        return data_;
+    }
+
+  private:
+    template <typename Weight>
+    void BuildStrong(const CsrGraph<Weight> &graph);
+    template <typename Weight>
+    void BuildWeak(const CsrGraph<Weight> &graph);
+    void CountComponents();
+
+    static constexpr uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+
+    Data data_;
+    size_t weak_count_ = 0;
+    size_t strong_count_ = 0;
+};
+
+template <typename Weight>
+ComponentIndex::ComponentIndex(const CsrGraph<Weight> &graph) {
+    BuildStrong(graph);
+    BuildWeak(graph);
+    CountComponents();
+}
+
+inline ComponentIndex::ComponentIndex(Data data) : data_(std::move(data)) {
+    if (data_.strong.size() != data_.weak.size()) {
+        throw std::invalid_argument("Component data of different sizes");
+    }
+    CountComponents();
+}
+
+inline void ComponentIndex::CountComponents() {
+    weak_count_ = 0;
+    strong_count_ = 0;
+    for (VertexId vertex = 0; vertex < data_.strong.size(); ++vertex) {
+        weak_count_ = std::max<size_t>(weak_count_, data_.weak[vertex] + 1);
+        strong_count_ = std::max<size_t>(strong_count_, data_.strong[vertex] + 1);
+    }
+}
+
+// Tarjan's algorithm with an explicit stack of (vertex, next arc) frames, so long
+// feeder lines don't overflow the call stack. A strong component is numbered when its
+// root finishes, which happens after every component it leads to.
+template <typename Weight>
+void ComponentIndex::BuildStrong(const CsrGraph<Weight> &graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<uint32_t> order(vertex_count, NO_INDEX);
+    std::vector<uint32_t> low(vertex_count);
+    std::vector<VertexId> component_stack;
+    std::vector<std::pair<VertexId, size_t>> frames;
+    data_.strong.assign(vertex_count, NO_INDEX);
+    uint32_t next_order = 0;
+    uint32_t next_component = 0;
+
+    for (VertexId root = 0; root < vertex_count; ++root) {
+        if (order[root] != NO_INDEX) {
+            continue;
+        }
+        order[root] = low[root] = next_order++;
+        component_stack.push_back(root);
+        frames.push_back({root, graph.GetArcsBegin(root)});
+
+        while (!frames.empty()) {
+            auto &[vertex, arc] = frames.back();
+            if (arc < graph.GetArcsEnd(vertex)) {
+                const VertexId target = graph.GetTarget(arc++);
+                if (order[target] == NO_INDEX) {
+                    order[target] = low[target] = next_order++;
+                    component_stack.push_back(target);
+                    frames.push_back({target, graph.GetArcsBegin(target)});
+                } else if (data_.strong[target] == NO_INDEX) {
+                    low[vertex] = std::min(low[vertex], order[target]);
+                }
+                continue;
+            }
+
+            const VertexId finished = vertex;
+            frames.pop_back();
+            if (!frames.empty()) {
+                const VertexId parent = frames.back().first;
+                low[parent] = std::min(low[parent], low[finished]);
+            }
+            if (low[finished] == order[finished]) {
+                VertexId member;
+                do {
+                    member = component_stack.back();
+                    component_stack.pop_back();
+                    data_.strong[member] = next_component;
+                } while (member != finished);
+                ++next_component;
+            }
+        }
+    }
+}
+
+// Union-find over the arcs with path halving, then dense numbers in vertex order.
+template <typename Weight>
+void ComponentIndex::BuildWeak(const CsrGraph<Weight> &graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<uint32_t> parents(vertex_count);
+    std::iota(parents.begin(), parents.end(), 0);
+    const auto find_root = [&parents](uint32_t vertex) {
+        while (parents[vertex] != vertex) {
+            parents[vertex] = parents[parents[vertex]];
+            vertex = parents[vertex];
+        }
+        return vertex;
+    };
+
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (size_t arc = graph.GetArcsBegin(vertex); arc < graph.GetArcsEnd(vertex); ++arc) {
+            const uint32_t lhs = find_root(static_cast<uint32_t>(vertex));
+            const uint32_t rhs = find_root(static_cast<uint32_t>(graph.GetTarget(arc)));
+            parents[std::max(lhs, rhs)] = std::min(lhs, rhs);
+        }
+    }
+
+    data_.weak.assign(vertex_count, NO_INDEX);
+    uint32_t next_component = 0;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        const uint32_t root = find_root(static_cast<uint32_t>(vertex));
+        if (data_.weak[root] == NO_INDEX) {
+            data_.weak[root] = next_component++;
+        }
+        data_.weak[vertex] = data_.weak[root];
+    }
+}
+
+} // namespace graph
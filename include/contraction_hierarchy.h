@@ -0,0 +1,568 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Contraction Hierarchies: vertices are contracted one by one in order of importance,
+// and shortcuts are added wherever a contraction would break a shortest path. A query
+// is a bidirectional search that only climbs to more important vertices.
+//
+// Edge ids [0, E) of the hierarchy are the edges of the original graph, ids from E on
+// are shortcuts, each of them is the concatenation of two hierarchy edges.
+template <typename Weight>
+class ContractionHierarchy : public IRouter<Weight> {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue =
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+  public:
+    using RouteInfo = typename IRouter<Weight>::RouteInfo;
+
+    struct Shortcut {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId first;
+        EdgeId second;
+    };
+
+    struct Data {
+        std::vector<size_t> ranks;
+        std::vector<Shortcut> shortcuts;
+    };
+
+  public:
+    explicit ContractionHierarchy(const Graph &graph);
+    ContractionHierarchy(const Graph &graph, Data data);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    // One upward search from `from` serves every target; each target adds a downward
+    // search only, and no shortcut is unpacked.
+    std::vector<std::optional<Weight>>
+    BuildWeights(VertexId from, const std::vector<VertexId> &targets) const override;
+
+    // Rebuilds the shortcuts after the edge weights changed, contracting the vertices in
+    // the same order: the costly priority estimates are skipped.
+    void Customize();
+
+    const Data &GetData() const {
+        return data_;
+    }
+
+    // Calls callback(other, weight, edge_id) for the hierarchy edges from `vertex` to
+    // more important vertices (upward) or into it from more important ones (downward).
+    template <typename Callback>
+    void ForEachUpwardArc(VertexId vertex, Callback callback) const {
+        ForEachArc(upward_graph_, vertex, callback);
+    }
+    template <typename Callback>
+    void ForEachDownwardArc(VertexId vertex, Callback callback) const {
+        ForEachArc(downward_graph_, vertex, callback);
+    }
+
+    Edge<Weight> GetEdge(EdgeId edge_id) const {
+        if (edge_id < graph_.GetEdgeCount()) {
+            return graph_.GetEdge(edge_id);
+        }
+        const Shortcut &shortcut = data_.shortcuts[edge_id - graph_.GetEdgeCount()];
+        return {shortcut.from, shortcut.to, shortcut.weight};
+    }
+    // Appends the graph edges a hierarchy edge stands for, in route order.
+    void UnpackEdge(EdgeId edge_id, std::vector<EdgeId> &edges) const;
+
+  private:
+    struct Arc {
+        VertexId vertex;
+        Weight weight;
+        EdgeId edge;
+    };
+
+    struct SearchGraph {
+        std::vector<size_t> offsets;
+        std::vector<Arc> arcs;
+    };
+
+    struct Search {
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
+        std::vector<VertexId> touched;
+        Queue queue;
+    };
+
+    class Builder;
+
+    template <typename Callback>
+    static void
+    ForEachArc(const SearchGraph &search_graph, VertexId vertex, Callback callback) {
+        for (size_t idx = search_graph.offsets[vertex]; idx < search_graph.offsets[vertex + 1];
+             ++idx) {
+            const Arc &arc = search_graph.arcs[idx];
+            callback(arc.vertex, arc.weight, arc.edge);
+        }
+    }
+
+    void BuildSearchGraphs();
+    void InitializeSearch(Search &search) const;
+    void Relax(Search &search, VertexId vertex, Weight weight, EdgeId prev_edge) const;
+    void Reset(Search &search) const;
+    void SearchStep(Search &search,
+                    const SearchGraph &search_graph,
+                    const Search &opposite,
+                    Weight &best_weight,
+                    VertexId &meeting_vertex) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::max();
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+    static constexpr VertexId NO_VERTEX = std::numeric_limits<VertexId>::max();
+
+    const Graph &graph_;
+    Data data_;
+    SearchGraph upward_graph_;
+    SearchGraph downward_graph_;
+    mutable Search forward_search_;
+    mutable Search backward_search_;
+};
+
+template <typename Weight>
+class ContractionHierarchy<Weight>::Builder {
+  public:
+    Builder(const Graph &graph, Data &data)
+        : graph_(graph), data_(data), out_arcs_(graph.GetVertexCount()),
+          in_arcs_(graph.GetVertexCount()), contracted_(graph.GetVertexCount(), false),
+          contracted_neighbours_(graph.GetVertexCount(), 0),
+          witness_weights_(graph.GetVertexCount(), UNREACHED) {
+
+        for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                const auto &edge = graph.GetEdge(edge_id);
+                if (edge.weight < ZERO_WEIGHT) {
+                    throw std::domain_error("Edge's weights should be non-negative");
+                }
+                if (edge.from != edge.to) {
+                    AddArc(edge.from, edge.to, edge.weight, edge_id);
+                }
+            }
+        }
+    }
+
+    void Contract() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        data_.ranks.assign(vertex_count, 0);
+
+        using PriorityItem = std::pair<long, VertexId>;
+        using PriorityQueue = std::priority_queue<PriorityItem, std::vector<PriorityItem>,
+                                                  std::greater<PriorityItem>>;
+        PriorityQueue queue;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            queue.push({GetPriority(vertex), vertex});
+        }
+
+        size_t rank = 0;
+        while (!queue.empty()) {
+            const VertexId vertex = queue.top().second;
+            queue.pop();
+
+            const long priority = GetPriority(vertex);
+            if (!queue.empty() && priority > queue.top().first) {
+                queue.push({priority, vertex});
+                continue;
+            }
+            ContractVertex(vertex);
+            data_.ranks[vertex] = rank++;
+        }
+    }
+
+    void Contract(std::vector<size_t> ranks) {
+        std::vector<VertexId> order(ranks.size());
+        for (VertexId vertex = 0; vertex < ranks.size(); ++vertex) {
+            order[ranks[vertex]] = vertex;
+        }
+        for (const VertexId vertex : order) {
+            ContractVertex(vertex);
+        }
+        data_.ranks = std::move(ranks);
+    }
+
+  private:
+    bool AddArc(VertexId from, VertexId to, Weight weight, EdgeId edge_id) {
+        for (Arc &arc : out_arcs_[from]) {
+            if (arc.vertex != to) {
+                continue;
+            }
+            if (arc.weight <= weight) {
+                return false;
+            }
+            arc = {to, weight, edge_id};
+            for (Arc &in_arc : in_arcs_[to]) {
+                if (in_arc.vertex == from) {
+                    in_arc = {from, weight, edge_id};
+                }
+            }
+            return true;
+        }
+        out_arcs_[from].push_back({to, weight, edge_id});
+        in_arcs_[to].push_back({from, weight, edge_id});
+        return true;
+    }
+
+    template <typename Callback>
+    void ForEachShortcut(VertexId vertex, size_t settled_limit, Callback callback) {
+        for (const Arc &in_arc : in_arcs_[vertex]) {
+            Weight max_weight = ZERO_WEIGHT;
+            for (const Arc &out_arc : out_arcs_[vertex]) {
+                if (out_arc.vertex != in_arc.vertex) {
+                    max_weight = std::max(max_weight, in_arc.weight + out_arc.weight);
+                }
+            }
+            FindWitnesses(in_arc.vertex, vertex, max_weight, settled_limit);
+            for (const Arc &out_arc : out_arcs_[vertex]) {
+                const Weight weight = in_arc.weight + out_arc.weight;
+                if (out_arc.vertex != in_arc.vertex &&
+                    witness_weights_[out_arc.vertex] > weight) {
+                    callback(in_arc, out_arc);
+                }
+            }
+            ResetWitnesses();
+        }
+    }
+
+    long GetPriority(VertexId vertex) {
+        long shortcut_count = 0;
+        ForEachShortcut(vertex, PRIORITY_SETTLED_LIMIT,
+                        [&shortcut_count](const Arc &, const Arc &) { ++shortcut_count; });
+        const long degree = in_arcs_[vertex].size() + out_arcs_[vertex].size();
+        return shortcut_count - degree + contracted_neighbours_[vertex];
+    }
+
+    void ContractVertex(VertexId vertex) {
+        std::vector<Shortcut> shortcuts;
+        ForEachShortcut(vertex, CONTRACTION_SETTLED_LIMIT, [&](const Arc &in_arc,
+                                                                const Arc &out_arc) {
+            shortcuts.push_back({in_arc.vertex, out_arc.vertex, in_arc.weight + out_arc.weight,
+                                 in_arc.edge, out_arc.edge});
+        });
+        for (const Shortcut &shortcut : shortcuts) {
+            if (AddArc(shortcut.from, shortcut.to, shortcut.weight,
+                       graph_.GetEdgeCount() + data_.shortcuts.size())) {
+                data_.shortcuts.push_back(shortcut);
+            }
+        }
+
+        contracted_[vertex] = true;
+        const auto is_contracted = [vertex](const Arc &arc) {
+            return arc.vertex == vertex;
+        };
+        for (const Arc &arc : in_arcs_[vertex]) {
+            auto &arcs = out_arcs_[arc.vertex];
+            arcs.erase(std::remove_if(arcs.begin(), arcs.end(), is_contracted), arcs.end());
+            ++contracted_neighbours_[arc.vertex];
+        }
+        for (const Arc &arc : out_arcs_[vertex]) {
+            auto &arcs = in_arcs_[arc.vertex];
+            arcs.erase(std::remove_if(arcs.begin(), arcs.end(), is_contracted), arcs.end());
+            ++contracted_neighbours_[arc.vertex];
+        }
+        in_arcs_[vertex].clear();
+        out_arcs_[vertex].clear();
+    }
+
+    void
+    FindWitnesses(VertexId from, VertexId ignored, Weight max_weight, size_t settled_limit) {
+        Queue queue;
+        witness_weights_[from] = ZERO_WEIGHT;
+        witness_touched_.push_back(from);
+        queue.push({ZERO_WEIGHT, from});
+
+        size_t settled_count = 0;
+        while (!queue.empty() && settled_count++ < settled_limit) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight > max_weight) {
+                break;
+            }
+            if (weight > witness_weights_[vertex]) {
+                continue;
+            }
+            for (const Arc &arc : out_arcs_[vertex]) {
+                const Weight candidate_weight = weight + arc.weight;
+                if (arc.vertex == ignored ||
+                    candidate_weight >= witness_weights_[arc.vertex]) {
+                    continue;
+                }
+                if (witness_weights_[arc.vertex] == UNREACHED) {
+                    witness_touched_.push_back(arc.vertex);
+                }
+                witness_weights_[arc.vertex] = candidate_weight;
+                queue.push({candidate_weight, arc.vertex});
+            }
+        }
+    }
+
+    void ResetWitnesses() {
+        for (const VertexId vertex : witness_touched_) {
+            witness_weights_[vertex] = UNREACHED;
+        }
+        witness_touched_.clear();
+    }
+
+    // Witness searches are cut off early: a missed witness only costs a redundant
+    // shortcut, and the priority of a vertex is just an estimate anyway
+    static constexpr size_t PRIORITY_SETTLED_LIMIT = 50;
+    static constexpr size_t CONTRACTION_SETTLED_LIMIT = 500;
+
+    const Graph &graph_;
+    Data &data_;
+    std::vector<std::vector<Arc>> out_arcs_;
+    std::vector<std::vector<Arc>> in_arcs_;
+    std::vector<bool> contracted_;
+    std::vector<long> contracted_neighbours_;
+    std::vector<Weight> witness_weights_;
+    std::vector<VertexId> witness_touched_;
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph &graph) : graph_(graph) {
+    Builder(graph_, data_).Contract();
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph &graph, Data data)
+    : graph_(graph), data_(std::move(data)) {
+    if (data_.ranks.size() != graph_.GetVertexCount()) {
+        throw std::invalid_argument("Hierarchy doesn't match the graph");
+    }
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::Customize() {
+    std::vector<size_t> ranks = std::move(data_.ranks);
+    data_ = {};
+    Builder(graph_, data_).Contract(std::move(ranks));
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::BuildSearchGraphs() {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const auto &ranks = data_.ranks;
+
+    // Removed graph edges are no longer in the incidence lists and are skipped.
+    const auto for_each_edge = [this, vertex_count](auto callback) {
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                callback(edge_id, graph_.GetEdge(edge_id));
+            }
+        }
+        for (size_t idx = 0; idx < data_.shortcuts.size(); ++idx) {
+            const EdgeId edge_id = graph_.GetEdgeCount() + idx;
+            callback(edge_id, GetEdge(edge_id));
+        }
+    };
+
+    upward_graph_.offsets.assign(vertex_count + 1, 0);
+    downward_graph_.offsets.assign(vertex_count + 1, 0);
+    for_each_edge([&](EdgeId, const Edge<Weight> &edge) {
+        if (ranks[edge.from] < ranks[edge.to]) {
+            ++upward_graph_.offsets[edge.from + 1];
+        } else if (ranks[edge.from] > ranks[edge.to]) {
+            ++downward_graph_.offsets[edge.to + 1];
+        }
+    });
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        upward_graph_.offsets[vertex + 1] += upward_graph_.offsets[vertex];
+        downward_graph_.offsets[vertex + 1] += downward_graph_.offsets[vertex];
+    }
+
+    upward_graph_.arcs.resize(upward_graph_.offsets.back());
+    downward_graph_.arcs.resize(downward_graph_.offsets.back());
+    std::vector<size_t> upward_positions(upward_graph_.offsets.begin(),
+                                         upward_graph_.offsets.end() - 1);
+    std::vector<size_t> downward_positions(downward_graph_.offsets.begin(),
+                                           downward_graph_.offsets.end() - 1);
+    for_each_edge([&](EdgeId edge_id, const Edge<Weight> &edge) {
+        if (ranks[edge.from] < ranks[edge.to]) {
+            upward_graph_.arcs[upward_positions[edge.from]++] = {edge.to, edge.weight,
+                                                                 edge_id};
+        } else if (ranks[edge.from] > ranks[edge.to]) {
+            downward_graph_.arcs[downward_positions[edge.to]++] = {edge.from, edge.weight,
+                                                                  edge_id};
+        }
+    });
+
+    InitializeSearch(forward_search_);
+    InitializeSearch(backward_search_);
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::InitializeSearch(Search &search) const {
+    search.weights.assign(graph_.GetVertexCount(), UNREACHED);
+    search.prev_edges.assign(graph_.GetVertexCount(), NO_EDGE);
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::Relax(Search &search,
+                                         VertexId vertex,
+                                         Weight weight,
+                                         EdgeId prev_edge) const {
+    if (search.weights[vertex] == UNREACHED) {
+        search.touched.push_back(vertex);
+    } else if (search.weights[vertex] <= weight) {
+        return;
+    }
+    search.weights[vertex] = weight;
+    search.prev_edges[vertex] = prev_edge;
+    search.queue.push({weight, vertex});
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::Reset(Search &search) const {
+    for (const VertexId vertex : search.touched) {
+        search.weights[vertex] = UNREACHED;
+        search.prev_edges[vertex] = NO_EDGE;
+    }
+    search.touched.clear();
+    search.queue = Queue();
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::SearchStep(Search &search,
+                                              const SearchGraph &search_graph,
+                                              const Search &opposite,
+                                              Weight &best_weight,
+                                              VertexId &meeting_vertex) const {
+    const auto [weight, vertex] = search.queue.top();
+    search.queue.pop();
+    if (weight > search.weights[vertex]) {
+        return;
+    }
+    if (opposite.weights[vertex] != UNREACHED &&
+        weight + opposite.weights[vertex] < best_weight) {
+        best_weight = weight + opposite.weights[vertex];
+        meeting_vertex = vertex;
+    }
+    for (size_t idx = search_graph.offsets[vertex]; idx < search_graph.offsets[vertex + 1];
+         ++idx) {
+        const Arc &arc = search_graph.arcs[idx];
+        Relax(search, arc.vertex, weight + arc.weight, arc.edge);
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::UnpackEdge(EdgeId edge_id,
+                                              std::vector<EdgeId> &edges) const {
+    std::vector<EdgeId> stack{edge_id};
+    while (!stack.empty()) {
+        const EdgeId id = stack.back();
+        stack.pop_back();
+        if (id < graph_.GetEdgeCount()) {
+            edges.push_back(id);
+            continue;
+        }
+        const Shortcut &shortcut = data_.shortcuts[id - graph_.GetEdgeCount()];
+        stack.push_back(shortcut.second);
+        stack.push_back(shortcut.first);
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchy<Weight>::RouteInfo>
+ContractionHierarchy<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    if (from == to) {
+        return RouteInfo{ZERO_WEIGHT, {}};
+    }
+
+    Relax(forward_search_, from, ZERO_WEIGHT, NO_EDGE);
+    Relax(backward_search_, to, ZERO_WEIGHT, NO_EDGE);
+
+    Weight best_weight = UNREACHED;
+    VertexId meeting_vertex = NO_VERTEX;
+    auto &forward_queue = forward_search_.queue;
+    auto &backward_queue = backward_search_.queue;
+    while (true) {
+        const bool forward_done =
+            forward_queue.empty() || forward_queue.top().first >= best_weight;
+        const bool backward_done =
+            backward_queue.empty() || backward_queue.top().first >= best_weight;
+        if (forward_done && backward_done) {
+            break;
+        }
+        if (backward_done ||
+            (!forward_done && forward_queue.top().first <= backward_queue.top().first)) {
+            SearchStep(forward_search_, upward_graph_, backward_search_, best_weight,
+                       meeting_vertex);
+        } else {
+            SearchStep(backward_search_, downward_graph_, forward_search_, best_weight,
+                       meeting_vertex);
+        }
+    }
+
+    std::optional<RouteInfo> route;
+    if (meeting_vertex != NO_VERTEX) {
+        route = RouteInfo{best_weight, {}};
+        std::vector<EdgeId> forward_edges;
+        for (VertexId vertex = meeting_vertex; forward_search_.prev_edges[vertex] != NO_EDGE;
+             vertex = GetEdge(forward_search_.prev_edges[vertex]).from) {
+            forward_edges.push_back(forward_search_.prev_edges[vertex]);
+        }
+        for (auto it = forward_edges.rbegin(); it != forward_edges.rend(); ++it) {
+            UnpackEdge(*it, route->edges);
+        }
+        for (VertexId vertex = meeting_vertex; backward_search_.prev_edges[vertex] != NO_EDGE;
+             vertex = GetEdge(backward_search_.prev_edges[vertex]).to) {
+            UnpackEdge(backward_search_.prev_edges[vertex], route->edges);
+        }
+    }
+
+    Reset(forward_search_);
+    Reset(backward_search_);
+    return route;
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>>
+ContractionHierarchy<Weight>::BuildWeights(VertexId from,
+                                           const std::vector<VertexId> &targets) const {
+    Weight best_weight = UNREACHED;
+    VertexId meeting_vertex = NO_VERTEX;
+    Relax(forward_search_, from, ZERO_WEIGHT, NO_EDGE);
+    while (!forward_search_.queue.empty()) {
+        SearchStep(forward_search_, upward_graph_, backward_search_, best_weight,
+                   meeting_vertex);
+    }
+
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(targets.size());
+    for (const VertexId to : targets) {
+        best_weight = UNREACHED;
+        Relax(backward_search_, to, ZERO_WEIGHT, NO_EDGE);
+        auto &backward_queue = backward_search_.queue;
+        while (!backward_queue.empty() && backward_queue.top().first < best_weight) {
+            SearchStep(backward_search_, downward_graph_, forward_search_, best_weight,
+                       meeting_vertex);
+        }
+        weights.push_back(best_weight != UNREACHED ? std::optional<Weight>(best_weight)
+                                                   : std::nullopt);
+        Reset(backward_search_);
+    }
+
+    Reset(forward_search_);
+    return weights;
+}
+
+} // namespace graph
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Frozen compressed sparse row form of DirectedWeightedGraph: arcs leaving vertex v
+// occupy [offsets[v], offsets[v + 1]) of the targets, weights and edge ids arrays,
+// in the same order as the incidence list they were built from. Edge ids keep the id
+// space of the source graph, ids of removed edges included.
+//
+// The arrays but the weights are immutable and shared by copies, so graphs that differ
+// in weights only, see WithWeights, cost one weights array each.
+template <typename Weight>
+class CsrGraph {
+  public:
+    CsrGraph() = default;
+    explicit CsrGraph(const DirectedWeightedGraph<Weight> &graph);
+    // edge_count is raised to cover every edge id, so zero takes it from the largest one.
+    CsrGraph(std::vector<uint32_t> offsets,
+             std::vector<uint32_t> targets,
+             std::vector<Weight> weights,
+             std::vector<uint32_t> edge_ids,
+             size_t edge_count = 0);
+
+    // The same arcs with weights[arc] each.
+    CsrGraph WithWeights(std::vector<Weight> weights) const;
+
+    size_t GetVertexCount() const {
+        return topology_->offsets.empty() ? 0 : topology_->offsets.size() - 1;
+    }
+    size_t GetArcCount() const {
+        return topology_->targets.size();
+    }
+    // Size of the edge id space, not less than GetArcCount().
+    size_t GetEdgeCount() const {
+        return topology_->edge_count;
+    }
+
+    size_t GetArcsBegin(VertexId vertex) const {
+        return topology_->offsets[vertex];
+    }
+    size_t GetArcsEnd(VertexId vertex) const {
+        return topology_->offsets[vertex + 1];
+    }
+    VertexId GetTarget(size_t arc) const {
+        return topology_->targets[arc];
+    }
+    Weight GetWeight(size_t arc) const {
+        return weights_[arc];
+    }
+    EdgeId GetEdgeId(size_t arc) const {
+        return topology_->edge_ids[arc];
+    }
+
+    const std::vector<uint32_t> &GetOffsets() const {
+        return topology_->offsets;
+    }
+    const std::vector<uint32_t> &GetTargets() const {
+        return topology_->targets;
+    }
+    const std::vector<Weight> &GetWeights() const {
+        return weights_;
+    }
+    const std::vector<uint32_t> &GetEdgeIds() const {
+        return topology_->edge_ids;
+    }
+
+    DirectedWeightedGraph<Weight> ToGraph() const;
+
+  private:
+    struct Topology {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> targets;
+        std::vector<uint32_t> edge_ids;
+        size_t edge_count = 0;
+    };
+
+    std::shared_ptr<const Topology> topology_ = std::make_shared<const Topology>();
+    std::vector<Weight> weights_;
+};
+
+template <typename Weight>
+CsrGraph<Weight>::CsrGraph(const DirectedWeightedGraph<Weight> &graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    Topology topology;
+    topology.edge_count = graph.GetEdgeCount();
+    topology.offsets.reserve(vertex_count + 1);
+    topology.targets.reserve(graph.GetEdgeCount());
+    topology.edge_ids.reserve(graph.GetEdgeCount());
+    weights_.reserve(graph.GetEdgeCount());
+
+    topology.offsets.push_back(0);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto &edge = graph.GetEdge(edge_id);
+            topology.targets.push_back(edge.to);
+            weights_.push_back(edge.weight);
+            topology.edge_ids.push_back(edge_id);
+        }
+        topology.offsets.push_back(topology.targets.size());
+    }
+    topology_ = std::make_shared<const Topology>(std::move(topology));
+}
+
+template <typename Weight>
+CsrGraph<Weight>::CsrGraph(std::vector<uint32_t> offsets,
+                           std::vector<uint32_t> targets,
+                           std::vector<Weight> weights,
+                           std::vector<uint32_t> edge_ids,
+                           size_t edge_count)
+    : weights_(std::move(weights)) {
+    if (!edge_ids.empty()) {
+        edge_count = std::max<size_t>(edge_count,
+                                      *std::max_element(edge_ids.begin(), edge_ids.end()) + 1);
+    }
+    topology_ = std::make_shared<const Topology>(
+        Topology{std::move(offsets), std::move(targets), std::move(edge_ids), edge_count});
+}
+
+template <typename Weight>
+CsrGraph<Weight> CsrGraph<Weight>::WithWeights(std::vector<Weight> weights) const {
+    if (weights.size() != GetArcCount()) {
+        throw std::invalid_argument("Weights don't match the arcs");
+    }
+    CsrGraph graph;
+    graph.topology_ = topology_;
+    graph.weights_ = std::move(weights);
+    return graph;
+}
+
+// Ids of removed edges have no arc; they stay taken in the rebuilt graph but are left
+// out of the incidence lists.
+template <typename Weight>
+DirectedWeightedGraph<Weight> CsrGraph<Weight>::ToGraph() const {
+    std::vector<Edge<Weight>> edges(GetEdgeCount());
+    std::vector<bool> is_present(GetEdgeCount(), false);
+    for (VertexId vertex = 0; vertex < GetVertexCount(); ++vertex) {
+        for (size_t arc = GetArcsBegin(vertex); arc < GetArcsEnd(vertex); ++arc) {
+            edges[GetEdgeId(arc)] = {vertex, GetTarget(arc), weights_[arc]};
+            is_present[GetEdgeId(arc)] = true;
+        }
+    }
+
+    DirectedWeightedGraph<Weight> graph(GetVertexCount(), edges);
+    for (EdgeId edge_id = 0; edge_id < GetEdgeCount(); ++edge_id) {
+        if (!is_present[edge_id]) {
+            graph.RemoveEdge(edge_id);
+        }
+    }
+    return graph;
+}
+
+} // namespace graph
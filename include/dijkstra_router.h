@@ -0,0 +1,235 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Answers every query with a single-source search instead of the all-pairs table,
+// so construction is O(E) and memory is O(V + E). With a potential the search turns
+// into A*: potential(vertex, to) must be a lower bound of the remaining weight that
+// never drops by more than an edge weight along that edge.
+template <typename Weight>
+class DijkstraRouter : public IRouter<Weight> {
+  private:
+    using Graph = CsrGraph<Weight>;
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue =
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+  public:
+    using RouteInfo = typename IRouter<Weight>::RouteInfo;
+    using Potential = std::function<Weight(VertexId vertex, VertexId to)>;
+
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::max();
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    // Shortest-path tree of one source: the weight and the last edge of the route to
+    // every vertex, UNREACHED and NO_EDGE where there is none. The source has NO_EDGE.
+    struct Tree {
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
+    };
+
+  public:
+    explicit DijkstraRouter(const Graph &graph, Potential potential = {});
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    // Weights of the routes from `from` to every vertex, UNREACHED where there is none.
+    std::vector<Weight> BuildWeights(VertexId from) const;
+    Tree BuildTree(VertexId from) const;
+    std::vector<std::optional<Weight>>
+    BuildWeights(VertexId from, const std::vector<VertexId> &targets) const override;
+    // Vertices within max_weight of `from` with their weights; the search stops at the
+    // first vertex beyond the bound.
+    std::vector<std::pair<VertexId, Weight>> BuildReachable(VertexId from,
+                                                            Weight max_weight) const;
+
+    size_t GetLastSettledCount() const {
+        return settled_count_;
+    }
+
+  private:
+    void Search(VertexId from,
+                VertexId to,
+                Weight max_weight = UNREACHED,
+                size_t target_count = 0) const;
+
+    bool Relax(VertexId vertex,
+               Weight weight,
+               VertexId prev_vertex,
+               EdgeId prev_edge,
+               VertexId to) const {
+        if (weights_[vertex] == UNREACHED) {
+            touched_.push_back(vertex);
+            potentials_[vertex] = potential_ && to != NO_VERTEX ? potential_(vertex, to)
+                                                                : ZERO_WEIGHT;
+        } else if (weights_[vertex] <= weight) {
+            return false;
+        }
+        weights_[vertex] = weight;
+        prev_vertices_[vertex] = prev_vertex;
+        prev_edges_[vertex] = prev_edge;
+        return true;
+    }
+
+    void Reset() const {
+        for (const VertexId vertex : touched_) {
+            weights_[vertex] = UNREACHED;
+            prev_edges_[vertex] = NO_EDGE;
+        }
+        touched_.clear();
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr VertexId NO_VERTEX = std::numeric_limits<VertexId>::max();
+
+    const Graph &graph_;
+    Potential potential_;
+    mutable std::vector<Weight> weights_;
+    mutable std::vector<Weight> potentials_;
+    mutable std::vector<VertexId> prev_vertices_;
+    mutable std::vector<EdgeId> prev_edges_;
+    mutable std::vector<VertexId> touched_;
+    mutable std::vector<bool> is_target_;
+    mutable size_t settled_count_ = 0;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph &graph, Potential potential)
+    : graph_(graph), potential_(std::move(potential)),
+      weights_(graph.GetVertexCount(), UNREACHED), potentials_(graph.GetVertexCount()),
+      prev_vertices_(graph.GetVertexCount()), prev_edges_(graph.GetVertexCount(), NO_EDGE),
+      is_target_(graph.GetVertexCount(), false) {
+    for (const Weight weight : graph.GetWeights()) {
+        if (weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edge's weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo>
+DijkstraRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    Search(from, to);
+    if (weights_[to] == UNREACHED) {
+        Reset();
+        return std::nullopt;
+    }
+
+    RouteInfo route{weights_[to], {}};
+    for (VertexId vertex = to; prev_edges_[vertex] != NO_EDGE;
+         vertex = prev_vertices_[vertex]) {
+        route.edges.push_back(prev_edges_[vertex]);
+    }
+    std::reverse(route.edges.begin(), route.edges.end());
+
+    Reset();
+    return route;
+}
+
+template <typename Weight>
+std::vector<Weight> DijkstraRouter<Weight>::BuildWeights(VertexId from) const {
+    Search(from, NO_VERTEX);
+    std::vector<Weight> weights = weights_;
+    Reset();
+    return weights;
+}
+
+template <typename Weight>
+typename DijkstraRouter<Weight>::Tree DijkstraRouter<Weight>::BuildTree(VertexId from) const {
+    Search(from, NO_VERTEX);
+    Tree tree{weights_, prev_edges_};
+    Reset();
+    return tree;
+}
+
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>>
+DijkstraRouter<Weight>::BuildReachable(VertexId from, Weight max_weight) const {
+    Search(from, NO_VERTEX, max_weight);
+    std::vector<std::pair<VertexId, Weight>> reachable;
+    for (const VertexId vertex : touched_) {
+        if (weights_[vertex] <= max_weight) {
+            reachable.emplace_back(vertex, weights_[vertex]);
+        }
+    }
+    Reset();
+    return reachable;
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>>
+DijkstraRouter<Weight>::BuildWeights(VertexId from,
+                                     const std::vector<VertexId> &targets) const {
+    if (targets.empty()) {
+        return {};
+    }
+    size_t target_count = 0;
+    for (const VertexId to : targets) {
+        if (!is_target_[to]) {
+            is_target_[to] = true;
+            ++target_count;
+        }
+    }
+    Search(from, NO_VERTEX, UNREACHED, target_count);
+
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(targets.size());
+    for (const VertexId to : targets) {
+        is_target_[to] = false;
+        weights.push_back(weights_[to] != UNREACHED ? std::optional<Weight>(weights_[to])
+                                                    : std::nullopt);
+    }
+    Reset();
+    return weights;
+}
+
+// Settles vertices in order of weight plus potential until `to` is settled, or the
+// whole part of the graph reachable within max_weight when `to` is NO_VERTEX. A nonzero
+// target_count stops the search once that many vertices marked in is_target_ are settled.
+template <typename Weight>
+void DijkstraRouter<Weight>::Search(VertexId from,
+                                    VertexId to,
+                                    Weight max_weight,
+                                    size_t target_count) const {
+    Queue queue;
+    settled_count_ = 0;
+    Relax(from, ZERO_WEIGHT, from, NO_EDGE, to);
+    queue.push({potentials_[from], from});
+
+    while (!queue.empty()) {
+        const auto [key, vertex] = queue.top();
+        queue.pop();
+        const Weight weight = weights_[vertex];
+        if (key > weight + potentials_[vertex]) {
+            continue;
+        }
+        if (weight > max_weight) {
+            break;
+        }
+        ++settled_count_;
+        if (vertex == to || (is_target_[vertex] && --target_count == 0)) {
+            break;
+        }
+        const size_t arcs_end = graph_.GetArcsEnd(vertex);
+        for (size_t arc = graph_.GetArcsBegin(vertex); arc < arcs_end; ++arc) {
+            const VertexId target = graph_.GetTarget(arc);
+            const Weight candidate_weight = weight + graph_.GetWeight(arc);
+            if (Relax(target, candidate_weight, vertex, graph_.GetEdgeId(arc), to)) {
+                queue.push({candidate_weight + potentials_[target], target});
+            }
+        }
+    }
+}
+
+} // namespace graph
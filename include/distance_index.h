@@ -0,0 +1,50 @@
+#pragma once
+
+#include "domain.h"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tc {
+
+// Road distance from the first stop of the pair to the second.
+using StopsDist = std::unordered_map<std::pair<domain::StopId, domain::StopId>,
+                                     double,
+                                     domain::detail::StopIdPairHasher>;
+
+// Road distances as they were set, in compressed rows: the stops a distance is known to
+// from stop s, sorted by id, are at [offsets[s], offsets[s + 1]) of stops and
+// distances. A lookup is a binary search in one short row. The rows are what a base
+// stores.
+class DistanceIndex {
+  public:
+    struct Data {
+        std::vector<uint32_t> offsets;
+        std::vector<domain::StopId> stops;
+        std::vector<double> distances;
+    };
+
+  public:
+    DistanceIndex() = default;
+    explicit DistanceIndex(Data data);
+    // The rows of `index` with `distances` set over them, for stop_count stops.
+    DistanceIndex(const DistanceIndex &index, const StopsDist &distances, size_t stop_count);
+
+    // The distance set from `from` to `to`, the reverse pair is not looked at.
+    std::optional<double> Find(domain::StopId from, domain::StopId to) const;
+
+    size_t GetStopCount() const {
+        return data_.offsets.empty() ? 0 : data_.offsets.size() - 1;
+    }
+    const Data &GetData() const {
+        return data_;
+    }
+
+  private:
+    Data data_;
+};
+
+} // namespace tc
@@ -3,6 +3,8 @@
 #include "geo.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <set>
 #include <string>
@@ -10,9 +12,17 @@
 
 namespace domain {
 
+// Dense catalogue indexes, given in the order stops and buses are added.
+using StopId = uint32_t;
+using BusId = uint32_t;
+inline constexpr StopId NO_STOP_ID = std::numeric_limits<StopId>::max();
+inline constexpr BusId NO_BUS_ID = std::numeric_limits<BusId>::max();
+
+// `id` is set by the catalogue the object is added to.
 struct Stop {
     std::string name;
     geo::Coordinates coordinates;
+    StopId id = NO_STOP_ID;
 };
 using StopPtr = std::shared_ptr<Stop>;
 
@@ -21,6 +31,7 @@ struct Bus {
     std::vector<StopPtr> route;
     bool is_roundtrip = false;
     StopPtr final_stop;
+    BusId id = NO_BUS_ID;
 };
 using BusPtr = std::shared_ptr<Bus>;
 
@@ -33,12 +44,9 @@ struct BusStat {
 
 namespace detail {
 
-struct StopPtrPairHasher {
-    size_t operator()(const std::pair<StopPtr, StopPtr> &stops) const {
-        std::hash<void *> hasher;
-        size_t h_from = hasher(stops.first.get());
-        size_t h_to = hasher(stops.second.get());
-        return h_from * 31 + h_to;
+struct StopIdPairHasher {
+    size_t operator()(const std::pair<StopId, StopId> &stops) const {
+        return std::hash<uint64_t>{}(static_cast<uint64_t>(stops.first) << 32 | stops.second);
     }
 };
 
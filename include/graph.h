@@ -2,6 +2,7 @@
 
 #include "ranges.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <vector>
 
@@ -26,8 +27,13 @@ class DirectedWeightedGraph {
   public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
-    explicit DirectedWeightedGraph(const std::vector<Edge<Weight>> &edges);
+    DirectedWeightedGraph(size_t vertex_count, const std::vector<Edge<Weight>> &edges);
     EdgeId AddEdge(const Edge<Weight> &edge);
+    VertexId AddVertex();
+    void SetEdgeWeight(EdgeId edge_id, Weight weight);
+    // Detaches the edge from its incidence list. The id stays taken, so the ids of the
+    // other edges do not change.
+    void RemoveEdge(EdgeId edge_id);
 
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
@@ -45,8 +51,13 @@ DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
     : incidence_lists_(vertex_count) {}
 
 template <typename Weight>
-DirectedWeightedGraph<Weight>::DirectedWeightedGraph(const std::vector<Edge<Weight>> &edges)
-    : edges_(std::move(edges)) {}
+DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count,
+                                                     const std::vector<Edge<Weight>> &edges)
+    : edges_(edges), incidence_lists_(vertex_count) {
+    for (EdgeId id = 0; id < edges_.size(); ++id) {
+        incidence_lists_.at(edges_[id].from).push_back(id);
+    }
+}
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight> &edge) {
@@ -56,6 +67,26 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight> &edge) {
     return id;
 }
 
+template <typename Weight>
+VertexId DirectedWeightedGraph<Weight>::AddVertex() {
+    incidence_lists_.emplace_back();
+    return incidence_lists_.size() - 1;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::SetEdgeWeight(EdgeId edge_id, Weight weight) {
+    edges_.at(edge_id).weight = weight;
+}
+
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::RemoveEdge(EdgeId edge_id) {
+    auto &incidence_list = incidence_lists_.at(edges_.at(edge_id).from);
+    const auto it = std::find(incidence_list.begin(), incidence_list.end(), edge_id);
+    if (it != incidence_list.end()) {
+        incidence_list.erase(it);
+    }
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
     return incidence_lists_.size();
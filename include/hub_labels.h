@@ -0,0 +1,294 @@
+#pragma once
+
+#include "contraction_hierarchy.h"
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Hub labels over a contraction hierarchy. The forward label of a vertex lists the more
+// important vertices (hubs) its upward search reaches with their weights, the backward
+// label the same for the downward search into it; every shortest route passes a hub
+// common to both labels. A query merges two short lists sorted by hub, no search runs.
+//
+// Labels are built from the most important vertex down: the label of a vertex merges
+// the labels of the vertices its hierarchy edges lead to, and an entry is pruned when
+// another hub gives a strictly lighter route to the same hub. Every entry keeps the
+// first hierarchy edge towards its hub, and the label at the other end of that edge
+// has the hub too, so routes are unpacked entry by entry.
+template <typename Weight>
+class HubLabels : public IRouter<Weight> {
+  private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    using Hierarchy = ContractionHierarchy<Weight>;
+
+  public:
+    using RouteInfo = typename IRouter<Weight>::RouteInfo;
+
+    // Label of vertex v at [offsets[v], offsets[v + 1]) of hubs, weights and edges,
+    // sorted by hub. The entry of v itself has NO_LABEL_EDGE.
+    struct Labels {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> hubs;
+        std::vector<Weight> weights;
+        std::vector<uint32_t> edges;
+    };
+
+    struct Data {
+        Labels forward;
+        Labels backward;
+    };
+
+    static constexpr uint32_t NO_LABEL_EDGE = std::numeric_limits<uint32_t>::max();
+
+  public:
+    explicit HubLabels(const Graph &graph);
+    // Without labels in `data` they are built over the hierarchy.
+    HubLabels(const Graph &graph, typename Hierarchy::Data hierarchy, Data data = {});
+
+    HubLabels(const HubLabels &) = delete;
+    HubLabels &operator=(const HubLabels &) = delete;
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::vector<std::optional<Weight>>
+    BuildWeights(VertexId from, const std::vector<VertexId> &targets) const override;
+
+    // Customizes the hierarchy for new edge weights and rebuilds the labels.
+    void Customize();
+
+    const Hierarchy &GetHierarchy() const {
+        return hierarchy_;
+    }
+    const Data &GetData() const {
+        return data_;
+    }
+
+  private:
+    struct Entry {
+        uint32_t hub;
+        Weight weight;
+        uint32_t edge;
+    };
+
+    using LabelLists = std::vector<std::vector<Entry>>;
+
+    // Lightest common hub of the labels, UNREACHED and NO_VERTEX when there is none.
+    std::pair<Weight, VertexId> Intersect(VertexId from, VertexId to) const;
+    static uint32_t FindEdge(const Labels &labels, VertexId vertex, VertexId hub);
+
+    void BuildLabels();
+    template <typename ForEachArc>
+    static std::vector<Entry> BuildLabel(VertexId vertex,
+                                         const LabelLists &labels,
+                                         const LabelLists &opposite,
+                                         ForEachArc for_each_arc);
+    static Labels Flatten(const LabelLists &label_lists);
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHED = std::numeric_limits<Weight>::max();
+    static constexpr VertexId NO_VERTEX = std::numeric_limits<VertexId>::max();
+
+    Hierarchy hierarchy_;
+    Data data_;
+};
+
+template <typename Weight>
+HubLabels<Weight>::HubLabels(const Graph &graph) : hierarchy_(graph) {
+    BuildLabels();
+}
+
+template <typename Weight>
+HubLabels<Weight>::HubLabels(const Graph &graph,
+                             typename Hierarchy::Data hierarchy,
+                             Data data)
+    : hierarchy_(graph, std::move(hierarchy)), data_(std::move(data)) {
+    const size_t offsets_count = graph.GetVertexCount() + 1;
+    if (data_.forward.offsets.empty()) {
+        BuildLabels();
+    } else if (data_.forward.offsets.size() != offsets_count ||
+               data_.backward.offsets.size() != offsets_count) {
+        throw std::invalid_argument("Hub labels don't match the graph");
+    }
+}
+
+template <typename Weight>
+void HubLabels<Weight>::Customize() {
+    hierarchy_.Customize();
+    BuildLabels();
+}
+
+template <typename Weight>
+std::pair<Weight, VertexId> HubLabels<Weight>::Intersect(VertexId from, VertexId to) const {
+    const Labels &forward = data_.forward;
+    const Labels &backward = data_.backward;
+    uint32_t forward_idx = forward.offsets[from];
+    uint32_t backward_idx = backward.offsets[to];
+    const uint32_t forward_end = forward.offsets[from + 1];
+    const uint32_t backward_end = backward.offsets[to + 1];
+
+    std::pair<Weight, VertexId> best{UNREACHED, NO_VERTEX};
+    while (forward_idx < forward_end && backward_idx < backward_end) {
+        const uint32_t forward_hub = forward.hubs[forward_idx];
+        const uint32_t backward_hub = backward.hubs[backward_idx];
+        if (forward_hub < backward_hub) {
+            ++forward_idx;
+        } else if (backward_hub < forward_hub) {
+            ++backward_idx;
+        } else {
+            const Weight weight =
+                forward.weights[forward_idx] + backward.weights[backward_idx];
+            if (weight < best.first) {
+                best = {weight, forward_hub};
+            }
+            ++forward_idx;
+            ++backward_idx;
+        }
+    }
+    return best;
+}
+
+template <typename Weight>
+uint32_t HubLabels<Weight>::FindEdge(const Labels &labels, VertexId vertex, VertexId hub) {
+    const auto begin = labels.hubs.begin() + labels.offsets[vertex];
+    const auto end = labels.hubs.begin() + labels.offsets[vertex + 1];
+    return labels.edges[std::lower_bound(begin, end, hub) - labels.hubs.begin()];
+}
+
+template <typename Weight>
+std::optional<typename HubLabels<Weight>::RouteInfo>
+HubLabels<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const auto [weight, hub] = Intersect(from, to);
+    if (hub == NO_VERTEX) {
+        return std::nullopt;
+    }
+
+    RouteInfo route{weight, {}};
+    for (VertexId vertex = from; vertex != hub;) {
+        const EdgeId edge_id = FindEdge(data_.forward, vertex, hub);
+        hierarchy_.UnpackEdge(edge_id, route.edges);
+        vertex = hierarchy_.GetEdge(edge_id).to;
+    }
+    std::vector<EdgeId> backward_edges;
+    for (VertexId vertex = to; vertex != hub;) {
+        const EdgeId edge_id = FindEdge(data_.backward, vertex, hub);
+        backward_edges.push_back(edge_id);
+        vertex = hierarchy_.GetEdge(edge_id).from;
+    }
+    for (auto it = backward_edges.rbegin(); it != backward_edges.rend(); ++it) {
+        hierarchy_.UnpackEdge(*it, route.edges);
+    }
+    return route;
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>>
+HubLabels<Weight>::BuildWeights(VertexId from, const std::vector<VertexId> &targets) const {
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(targets.size());
+    for (const VertexId to : targets) {
+        const Weight weight = Intersect(from, to).first;
+        weights.push_back(weight != UNREACHED ? std::optional<Weight>(weight) : std::nullopt);
+    }
+    return weights;
+}
+
+template <typename Weight>
+void HubLabels<Weight>::BuildLabels() {
+    const auto &ranks = hierarchy_.GetData().ranks;
+    const size_t vertex_count = ranks.size();
+    std::vector<VertexId> order(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        order[vertex_count - 1 - ranks[vertex]] = vertex;
+    }
+
+    LabelLists forward(vertex_count);
+    LabelLists backward(vertex_count);
+    for (const VertexId vertex : order) {
+        forward[vertex] = BuildLabel(vertex, forward, backward, [&](auto callback) {
+            hierarchy_.ForEachUpwardArc(vertex, callback);
+        });
+        backward[vertex] = BuildLabel(vertex, backward, forward, [&](auto callback) {
+            hierarchy_.ForEachDownwardArc(vertex, callback);
+        });
+    }
+    data_.forward = Flatten(forward);
+    data_.backward = Flatten(backward);
+}
+
+// A sum of two labels does not depend on which of them is the forward one, so one
+// routine builds both kinds: `labels` are of the kind being built, `opposite` the others.
+template <typename Weight>
+template <typename ForEachArc>
+std::vector<typename HubLabels<Weight>::Entry>
+HubLabels<Weight>::BuildLabel(VertexId vertex,
+                              const LabelLists &labels,
+                              const LabelLists &opposite,
+                              ForEachArc for_each_arc) {
+    std::vector<Entry> label{{static_cast<uint32_t>(vertex), ZERO_WEIGHT, NO_LABEL_EDGE}};
+    for_each_arc([&](VertexId other, Weight weight, EdgeId edge_id) {
+        for (const Entry &entry : labels[other]) {
+            label.push_back(
+                {entry.hub, entry.weight + weight, static_cast<uint32_t>(edge_id)});
+        }
+    });
+    const auto by_hub = [](const Entry &lhs, const Entry &rhs) {
+        return lhs.hub < rhs.hub;
+    };
+    std::stable_sort(label.begin(), label.end(), [](const Entry &lhs, const Entry &rhs) {
+        return lhs.hub < rhs.hub || (lhs.hub == rhs.hub && lhs.weight < rhs.weight);
+    });
+    const auto same_hub = [](const Entry &lhs, const Entry &rhs) {
+        return lhs.hub == rhs.hub;
+    };
+    label.erase(std::unique(label.begin(), label.end(), same_hub), label.end());
+
+    // Lightest route to `hub` through another hub of the label.
+    const auto get_detour_weight = [&](uint32_t hub) {
+        Weight best = UNREACHED;
+        auto it = label.begin();
+        for (const Entry &entry : opposite[hub]) {
+            it = std::lower_bound(it, label.end(), entry, by_hub);
+            if (it == label.end()) {
+                break;
+            }
+            if (it->hub == entry.hub && entry.hub != hub) {
+                best = std::min(best, it->weight + entry.weight);
+            }
+        }
+        return best;
+    };
+    std::vector<Entry> result;
+    result.reserve(label.size());
+    for (const Entry &entry : label) {
+        if (entry.hub == vertex || !(get_detour_weight(entry.hub) < entry.weight)) {
+            result.push_back(entry);
+        }
+    }
+    return result;
+}
+
+template <typename Weight>
+typename HubLabels<Weight>::Labels HubLabels<Weight>::Flatten(const LabelLists &label_lists) {
+    Labels labels;
+    labels.offsets.reserve(label_lists.size() + 1);
+    labels.offsets.push_back(0);
+    for (const auto &label : label_lists) {
+        for (const Entry &entry : label) {
+            labels.hubs.push_back(entry.hub);
+            labels.weights.push_back(entry.weight);
+            labels.edges.push_back(entry.edge);
+        }
+        labels.offsets.push_back(labels.hubs.size());
+    }
+    return labels;
+}
+
+} // namespace graph
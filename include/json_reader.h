@@ -20,13 +20,24 @@ class JsonReader {
 
     const renderer::RendererSettings GetRendererSettings();
     const std::string GetSerializationSettings();
-    const router::RoutingSettings GetRoutingSettings();
+    bool HasRoutingSettings() const;
+    // Keys missing from the request keep their values from `settings`.
+    const router::RoutingSettings GetRoutingSettings(router::RoutingSettings settings = {});
 
   private:
     json::Node GetStopStat(const json::Dict &request, const tc::RequestHandler &handler) const;
     json::Node GetBusStat(const json::Dict &request, const tc::RequestHandler &handler) const;
     json::Node GetMap(const json::Dict &request, const tc::RequestHandler &handler) const;
     json::Node GetRoute(const json::Dict &request, const tc::RequestHandler &handler) const;
+    json::Node GetMatrix(const json::Dict &request, const tc::RequestHandler &handler) const;
+    json::Node GetReachable(const json::Dict &request,
+                            const tc::RequestHandler &handler) const;
+    json::Node GetNearbyStops(const json::Dict &request,
+                              const tc::RequestHandler &handler) const;
+
+    // The optional "profile" key of a Route, Matrix or Reachable request, empty for the
+    // base one.
+    static std::string_view GetProfile(const json::Dict &request);
 
     svg::Color ParseColor(const json::Node &node);
     
@@ -0,0 +1,207 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "dijkstra_router.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// ALT router: A* whose lower bounds come from the triangle inequality over the
+// distances to and from a few landmark vertices. Preprocessing runs 2K single-source
+// searches and keeps K * V forward and K * V backward weights.
+template <typename Weight>
+class LandmarkRouter : public IRouter<Weight> {
+  private:
+    using Graph = CsrGraph<Weight>;
+    using Search = DijkstraRouter<Weight>;
+
+  public:
+    using RouteInfo = typename IRouter<Weight>::RouteInfo;
+
+    // Row l of from_landmarks holds the weights from landmark l to every vertex,
+    // row l of to_landmarks the weights from every vertex to it. UNREACHED marks
+    // missing routes.
+    struct Data {
+        std::vector<VertexId> landmarks;
+        std::vector<Weight> from_landmarks;
+        std::vector<Weight> to_landmarks;
+    };
+
+    static constexpr Weight UNREACHED = Search::UNREACHED;
+
+  public:
+    LandmarkRouter(const Graph &graph, size_t landmark_count);
+    LandmarkRouter(const Graph &graph, Data data);
+
+    LandmarkRouter(const LandmarkRouter &) = delete;
+    LandmarkRouter &operator=(const LandmarkRouter &) = delete;
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override {
+        return search_.BuildRoute(from, to);
+    }
+    std::vector<std::optional<Weight>>
+    BuildWeights(VertexId from, const std::vector<VertexId> &targets) const override {
+        return search_.BuildWeights(from, targets);
+    }
+
+    // Recomputes the landmark weights after the edge weights of the graph changed,
+    // keeping the landmarks.
+    void Customize();
+
+    const Data &GetData() const {
+        return data_;
+    }
+    size_t GetLastSettledCount() const {
+        return search_.GetLastSettledCount();
+    }
+
+  private:
+    static Graph MakeReversedGraph(const Graph &graph);
+    void SelectLandmarks(size_t landmark_count);
+    std::vector<Weight>
+    AddLandmarkWeights(VertexId landmark, const Search &forward, const Search &backward);
+    Weight GetLowerBound(VertexId vertex, VertexId to) const;
+
+    typename Search::Potential MakePotential() const {
+        return [this](VertexId vertex, VertexId to) { return GetLowerBound(vertex, to); };
+    }
+
+    const Graph &graph_;
+    Data data_;
+    Search search_;
+};
+
+template <typename Weight>
+LandmarkRouter<Weight>::LandmarkRouter(const Graph &graph, size_t landmark_count)
+    : graph_(graph), search_(graph, MakePotential()) {
+    SelectLandmarks(landmark_count);
+}
+
+template <typename Weight>
+LandmarkRouter<Weight>::LandmarkRouter(const Graph &graph, Data data)
+    : graph_(graph), data_(std::move(data)), search_(graph, MakePotential()) {}
+
+template <typename Weight>
+typename LandmarkRouter<Weight>::Graph
+LandmarkRouter<Weight>::MakeReversedGraph(const Graph &graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (size_t arc = 0; arc < graph.GetArcCount(); ++arc) {
+        ++offsets[graph.GetTarget(arc) + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+
+    std::vector<uint32_t> targets(graph.GetArcCount());
+    std::vector<Weight> weights(graph.GetArcCount());
+    std::vector<uint32_t> edge_ids(graph.GetArcCount());
+    std::vector<uint32_t> positions(offsets.begin(), offsets.end() - 1);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (size_t arc = graph.GetArcsBegin(vertex); arc < graph.GetArcsEnd(vertex); ++arc) {
+            const uint32_t position = positions[graph.GetTarget(arc)]++;
+            targets[position] = vertex;
+            weights[position] = graph.GetWeight(arc);
+            edge_ids[position] = graph.GetEdgeId(arc);
+        }
+    }
+    return Graph(std::move(offsets), std::move(targets), std::move(weights),
+                 std::move(edge_ids));
+}
+
+// Farthest-point selection: every next landmark is the vertex whose distance from the
+// closest landmark chosen so far is the largest, vertices that no landmark reaches
+// come first. The search starts from the vertex farthest from vertex 0.
+template <typename Weight>
+void LandmarkRouter<Weight>::SelectLandmarks(size_t landmark_count) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    landmark_count = std::min(landmark_count, vertex_count);
+    if (landmark_count == 0) {
+        return;
+    }
+
+    const Graph reversed_graph = MakeReversedGraph(graph_);
+    const Search forward(graph_);
+    const Search backward(reversed_graph);
+
+    const auto farthest = [](const std::vector<Weight> &weights,
+                             const std::vector<bool> &is_landmark) {
+        std::optional<VertexId> result;
+        for (VertexId vertex = 0; vertex < weights.size(); ++vertex) {
+            if (!is_landmark[vertex] && (!result || weights[vertex] > weights[*result])) {
+                result = vertex;
+            }
+        }
+        return result;
+    };
+
+    std::vector<bool> is_landmark(vertex_count, false);
+    std::vector<Weight> closest(forward.BuildWeights(0));
+    std::replace(closest.begin(), closest.end(), UNREACHED, Weight{});
+    auto next = farthest(closest, is_landmark);
+    std::fill(closest.begin(), closest.end(), UNREACHED);
+
+    while (next && data_.landmarks.size() < landmark_count) {
+        const VertexId landmark = *next;
+        is_landmark[landmark] = true;
+        data_.landmarks.push_back(landmark);
+
+        const auto from_landmark = AddLandmarkWeights(landmark, forward, backward);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            closest[vertex] = std::min(closest[vertex], from_landmark[vertex]);
+        }
+        next = farthest(closest, is_landmark);
+    }
+}
+
+template <typename Weight>
+void LandmarkRouter<Weight>::Customize() {
+    const Graph reversed_graph = MakeReversedGraph(graph_);
+    const Search forward(graph_);
+    const Search backward(reversed_graph);
+    data_.from_landmarks.clear();
+    data_.to_landmarks.clear();
+    for (const VertexId landmark : data_.landmarks) {
+        AddLandmarkWeights(landmark, forward, backward);
+    }
+}
+
+// Appends the rows of the landmark and returns the weights from it.
+template <typename Weight>
+std::vector<Weight> LandmarkRouter<Weight>::AddLandmarkWeights(VertexId landmark,
+                                                               const Search &forward,
+                                                               const Search &backward) {
+    const auto from_landmark = forward.BuildWeights(landmark);
+    const auto to_landmark = backward.BuildWeights(landmark);
+    data_.from_landmarks.insert(data_.from_landmarks.end(), from_landmark.begin(),
+                                from_landmark.end());
+    data_.to_landmarks.insert(data_.to_landmarks.end(), to_landmark.begin(),
+                              to_landmark.end());
+    return from_landmark;
+}
+
+// d(vertex, to) >= d(l, to) - d(l, vertex) and d(vertex, to) >= d(vertex, l) - d(to, l).
+template <typename Weight>
+Weight LandmarkRouter<Weight>::GetLowerBound(VertexId vertex, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    Weight bound{};
+    for (size_t landmark = 0; landmark < data_.landmarks.size(); ++landmark) {
+        const Weight *from_landmark = &data_.from_landmarks[landmark * vertex_count];
+        const Weight *to_landmark = &data_.to_landmarks[landmark * vertex_count];
+        if (from_landmark[vertex] != UNREACHED && from_landmark[to] != UNREACHED) {
+            bound = std::max(bound, from_landmark[to] - from_landmark[vertex]);
+        }
+        if (to_landmark[vertex] != UNREACHED && to_landmark[to] != UNREACHED) {
+            bound = std::max(bound, to_landmark[vertex] - to_landmark[to]);
+        }
+    }
+    return bound;
+}
+
+} // namespace graph
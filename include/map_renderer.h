@@ -85,7 +85,8 @@ class MapRenderer {
 
   public:
     MapRenderer() = default;
-    MapRenderer(const RendererSettings &settings, const domain::BusPtrSet &buses);
+    // Buses are drawn in the given order, by name as the catalogue gives them.
+    MapRenderer(const RendererSettings &settings, std::vector<domain::BusPtr> buses);
 
     svg::Document RenderMap() const;
     
@@ -102,7 +103,7 @@ class MapRenderer {
   private:
     const RendererSettings settings_;
     std::unique_ptr<SphereProjector> projector_;
-    const domain::BusPtrSet buses_;
+    const std::vector<domain::BusPtr> buses_;
     domain::StopPtrSet stops_;
 };
 
@@ -0,0 +1,525 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GRAPH_MIN_PLUS_AVX2
+#endif
+
+namespace graph::detail {
+
+// Cells per row of the panel kernel.
+inline constexpr size_t PANEL_SIZE = 32;
+
+// Vectorized min-plus update of a routes table row for double weights, the SIMD part
+// of Router::RelaxRow: a cell takes weight_from + weights_through[idx] when the route
+// through the vertex exists and is strictly lighter or the cell is unreachable. The
+// predecessor becomes prev_through[idx], or prev_from where that is no_prev_edge.
+// Comparisons become lane masks and the stores are blends, so the result is bit
+// identical to the scalar loop. The kernels return the index the scalar loop continues
+// from.
+
+#if defined(GRAPH_MIN_PLUS_AVX2)
+// Compiled for AVX2 whatever the target of the translation unit is; call it only when
+// HasAvx2() holds.
+__attribute__((target("avx2"))) inline size_t
+RelaxRowAvx2(double weight_from,
+             uint32_t prev_from,
+             const double *weights_through,
+             const uint32_t *prev_through,
+             double *weights_row,
+             uint32_t *prev_row,
+             size_t begin,
+             size_t end,
+             uint32_t unreachable,
+             uint32_t no_prev_edge) {
+    size_t idx = begin;
+    const __m256d from_weight = _mm256_set1_pd(weight_from);
+    const __m128i from_prev = _mm_set1_epi32(static_cast<int>(prev_from));
+    const __m128i unreachable_prev = _mm_set1_epi32(static_cast<int>(unreachable));
+    const __m128i no_prev = _mm_set1_epi32(static_cast<int>(no_prev_edge));
+    for (; idx + 4 <= end; idx += 4) {
+        const __m128i through_prev =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(prev_through + idx));
+        const __m128i row_prev =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(prev_row + idx));
+        const __m256d candidate =
+            _mm256_add_pd(from_weight, _mm256_loadu_pd(weights_through + idx));
+        const __m256d row_weight = _mm256_loadu_pd(weights_row + idx);
+
+        // The low halves of the 64-bit comparison lanes, one 32-bit lane per cell.
+        const __m256i lighter64 =
+            _mm256_castpd_si256(_mm256_cmp_pd(candidate, row_weight, _CMP_LT_OQ));
+        const __m128i lighter = _mm_castps_si128(
+            _mm_shuffle_ps(_mm_castsi128_ps(_mm256_castsi256_si128(lighter64)),
+                           _mm_castsi128_ps(_mm256_extracti128_si256(lighter64, 1)),
+                           _MM_SHUFFLE(2, 0, 2, 0)));
+        const __m128i better = _mm_andnot_si128(
+            _mm_cmpeq_epi32(through_prev, unreachable_prev),
+            _mm_or_si128(_mm_cmpeq_epi32(row_prev, unreachable_prev), lighter));
+        if (_mm_testz_si128(better, better)) {
+            continue;
+        }
+
+        const __m128i new_prev =
+            _mm_blendv_epi8(through_prev, from_prev, _mm_cmpeq_epi32(through_prev, no_prev));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(prev_row + idx),
+                         _mm_blendv_epi8(row_prev, new_prev, better));
+        _mm256_storeu_pd(weights_row + idx,
+                         _mm256_blendv_pd(row_weight, candidate,
+                                          _mm256_castsi256_pd(_mm256_cvtepi32_epi64(better))));
+    }
+    return idx;
+}
+
+// Predecessor of a tile cell that the through vertices lowered to weight. Weights only
+// decrease and every update is strict, so the first through vertex whose candidate is
+// exactly weight made the last update of the cell.
+inline uint32_t FindTileCellPrev(const double *column_weights,
+                                 const uint32_t *column_prevs,
+                                 const double *through_weights,
+                                 const uint32_t *through_prevs,
+                                 size_t through_stride,
+                                 const uint32_t *throughs,
+                                 size_t through_count,
+                                 size_t cell,
+                                 double weight,
+                                 uint32_t no_prev_edge) {
+    size_t idx = 0;
+    for (; idx + 1 < through_count; ++idx) {
+        const size_t through = throughs[idx];
+        if (column_weights[through] + through_weights[through * through_stride + cell] ==
+            weight) {
+            break;
+        }
+    }
+    const size_t through = throughs[idx];
+    const uint32_t prev = through_prevs[through * through_stride + cell];
+    return prev != no_prev_edge ? prev : column_prevs[through];
+}
+
+inline void RelaxTileCell(const double *column_weights,
+                          const uint32_t *column_prevs,
+                          const double *through_weights,
+                          const uint32_t *through_prevs,
+                          size_t through_stride,
+                          const uint32_t *throughs,
+                          size_t through_count,
+                          double *weights_row,
+                          uint32_t *prev_row,
+                          size_t cell,
+                          uint32_t no_prev_edge) {
+    double weight = weights_row[cell];
+    for (size_t idx = 0; idx < through_count; ++idx) {
+        const size_t through = throughs[idx];
+        weight = std::min(weight, column_weights[through] +
+                                      through_weights[through * through_stride + cell]);
+    }
+    if (weight < weights_row[cell]) {
+        weights_row[cell] = weight;
+        prev_row[cell] = FindTileCellPrev(column_weights, column_prevs, through_weights,
+                                          through_prevs, through_stride, throughs,
+                                          through_count, cell, weight, no_prev_edge);
+    }
+}
+
+// Cells [0, 4 * VECTOR_COUNT) of one tile row, kept in registers while the row is
+// relaxed through every through vertex in order, see RelaxTileRowSimd.
+template <size_t VECTOR_COUNT>
+__attribute__((target("avx2"))) inline void
+RelaxTileCellsAvx2(const double *column_weights,
+                   const uint32_t *column_prevs,
+                   const double *through_weights,
+                   const uint32_t *through_prevs,
+                   size_t through_stride,
+                   const uint32_t *throughs,
+                   size_t through_count,
+                   double *weights_row,
+                   uint32_t *prev_row,
+                   uint32_t no_prev_edge) {
+    __m256d cells[VECTOR_COUNT];
+#pragma GCC unroll 4
+    for (size_t vector = 0; vector < VECTOR_COUNT; ++vector) {
+        cells[vector] = _mm256_loadu_pd(weights_row + vector * 4);
+    }
+    for (size_t idx = 0; idx < through_count; ++idx) {
+        const size_t through = throughs[idx];
+        const __m256d from_weight = _mm256_set1_pd(column_weights[through]);
+        const double *weights_through = through_weights + through * through_stride;
+#pragma GCC unroll 4
+        for (size_t vector = 0; vector < VECTOR_COUNT; ++vector) {
+            // min_pd takes the second operand unless the first is lighter, as the
+            // scalar comparison does.
+            cells[vector] = _mm256_min_pd(
+                _mm256_add_pd(from_weight, _mm256_loadu_pd(weights_through + vector * 4)),
+                cells[vector]);
+        }
+    }
+
+    for (size_t vector = 0; vector < VECTOR_COUNT; ++vector) {
+        int lanes = _mm256_movemask_pd(_mm256_cmp_pd(
+            cells[vector], _mm256_loadu_pd(weights_row + vector * 4), _CMP_LT_OQ));
+        if (lanes == 0) {
+            continue;
+        }
+        _mm256_storeu_pd(weights_row + vector * 4, cells[vector]);
+        for (; lanes != 0; lanes &= lanes - 1) {
+            const size_t cell = vector * 4 + __builtin_ctz(lanes);
+            prev_row[cell] = FindTileCellPrev(column_weights, column_prevs, through_weights,
+                                              through_prevs, through_stride, throughs,
+                                              through_count, cell, weights_row[cell],
+                                              no_prev_edge);
+        }
+    }
+}
+
+__attribute__((target("avx2"))) inline void
+RelaxTileRowAvx2(const double *column_weights,
+                 const uint32_t *column_prevs,
+                 const double *through_weights,
+                 const uint32_t *through_prevs,
+                 size_t through_stride,
+                 const uint32_t *throughs,
+                 size_t through_count,
+                 double *weights_row,
+                 uint32_t *prev_row,
+                 size_t cell_count,
+                 uint32_t no_prev_edge) {
+    size_t cell = 0;
+    for (; cell + 16 <= cell_count; cell += 16) {
+        RelaxTileCellsAvx2<4>(column_weights, column_prevs, through_weights + cell,
+                              through_prevs + cell, through_stride, throughs, through_count,
+                              weights_row + cell, prev_row + cell, no_prev_edge);
+    }
+    for (; cell + 4 <= cell_count; cell += 4) {
+        RelaxTileCellsAvx2<1>(column_weights, column_prevs, through_weights + cell,
+                              through_prevs + cell, through_stride, throughs, through_count,
+                              weights_row + cell, prev_row + cell, no_prev_edge);
+    }
+    for (; cell < cell_count; ++cell) {
+        RelaxTileCell(column_weights, column_prevs, through_weights, through_prevs,
+                      through_stride, throughs, through_count, weights_row, prev_row, cell,
+                      no_prev_edge);
+    }
+}
+
+// GCC 12 warns on the undefined source operand its AVX-512 intrinsics pass.
+#pragma GCC diagnostic push
+#if !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// The same for 8 cells per vector.
+template <size_t VECTOR_COUNT>
+__attribute__((target("avx512f"))) inline void
+RelaxTileCellsAvx512(const double *column_weights,
+                     const uint32_t *column_prevs,
+                     const double *through_weights,
+                     const uint32_t *through_prevs,
+                     size_t through_stride,
+                     const uint32_t *throughs,
+                     size_t through_count,
+                     double *weights_row,
+                     uint32_t *prev_row,
+                     uint32_t no_prev_edge) {
+    __m512d cells[VECTOR_COUNT];
+#pragma GCC unroll 4
+    for (size_t vector = 0; vector < VECTOR_COUNT; ++vector) {
+        cells[vector] = _mm512_loadu_pd(weights_row + vector * 8);
+    }
+    for (size_t idx = 0; idx < through_count; ++idx) {
+        const size_t through = throughs[idx];
+        const __m512d from_weight = _mm512_set1_pd(column_weights[through]);
+        const double *weights_through = through_weights + through * through_stride;
+#pragma GCC unroll 4
+        for (size_t vector = 0; vector < VECTOR_COUNT; ++vector) {
+            cells[vector] = _mm512_min_pd(
+                _mm512_add_pd(from_weight, _mm512_loadu_pd(weights_through + vector * 8)),
+                cells[vector]);
+        }
+    }
+
+    for (size_t vector = 0; vector < VECTOR_COUNT; ++vector) {
+        unsigned lanes = _mm512_cmp_pd_mask(
+            cells[vector], _mm512_loadu_pd(weights_row + vector * 8), _CMP_LT_OQ);
+        if (lanes == 0) {
+            continue;
+        }
+        _mm512_storeu_pd(weights_row + vector * 8, cells[vector]);
+        for (; lanes != 0; lanes &= lanes - 1) {
+            const size_t cell = vector * 8 + __builtin_ctz(lanes);
+            prev_row[cell] = FindTileCellPrev(column_weights, column_prevs, through_weights,
+                                              through_prevs, through_stride, throughs,
+                                              through_count, cell, weights_row[cell],
+                                              no_prev_edge);
+        }
+    }
+}
+
+__attribute__((target("avx512f"))) inline void
+RelaxTileRowAvx512(const double *column_weights,
+                   const uint32_t *column_prevs,
+                   const double *through_weights,
+                   const uint32_t *through_prevs,
+                   size_t through_stride,
+                   const uint32_t *throughs,
+                   size_t through_count,
+                   double *weights_row,
+                   uint32_t *prev_row,
+                   size_t cell_count,
+                   uint32_t no_prev_edge) {
+    size_t cell = 0;
+    for (; cell + 32 <= cell_count; cell += 32) {
+        RelaxTileCellsAvx512<4>(column_weights, column_prevs, through_weights + cell,
+                                through_prevs + cell, through_stride, throughs, through_count,
+                                weights_row + cell, prev_row + cell, no_prev_edge);
+    }
+    for (; cell + 8 <= cell_count; cell += 8) {
+        RelaxTileCellsAvx512<1>(column_weights, column_prevs, through_weights + cell,
+                                through_prevs + cell, through_stride, throughs, through_count,
+                                weights_row + cell, prev_row + cell, no_prev_edge);
+    }
+    for (; cell < cell_count; ++cell) {
+        RelaxTileCell(column_weights, column_prevs, through_weights, through_prevs,
+                      through_stride, throughs, through_count, weights_row, prev_row, cell,
+                      no_prev_edge);
+    }
+}
+
+// Column panel of the blocked precompute for one row outside the block, PANEL_SIZE
+// cells in the block columns: they are relaxed through the block vertices in order,
+// the route to through vertex k being cell k as it stands at its turn. Those routes are
+// stored to column_weights and column_prevs for the tile stage. The cells stay in
+// registers, and cell k is broadcast from its register at its turn.
+__attribute__((target("avx512f"))) inline void
+RelaxPanelRowAvx512(const double *through_weights,
+                    const uint32_t *through_prevs,
+                    double *weights_row,
+                    uint32_t *prev_row,
+                    double *column_weights,
+                    uint32_t *column_prevs,
+                    uint32_t no_prev_edge) {
+    constexpr size_t VECTOR_COUNT = PANEL_SIZE / 8;
+    __m512d cells[VECTOR_COUNT];
+#pragma GCC unroll 4
+    for (size_t vector = 0; vector < VECTOR_COUNT; ++vector) {
+        cells[vector] = _mm512_loadu_pd(weights_row + vector * 8);
+    }
+#pragma GCC unroll 4
+    for (size_t vector_through = 0; vector_through < VECTOR_COUNT; ++vector_through) {
+        for (size_t lane = 0; lane < 8; ++lane) {
+            const size_t through = vector_through * 8 + lane;
+            const __m512d from_weight = _mm512_permutexvar_pd(
+                _mm512_set1_epi64(static_cast<long long>(lane)), cells[vector_through]);
+            column_weights[through] = _mm512_cvtsd_f64(from_weight);
+            const double *weights_through = through_weights + through * PANEL_SIZE;
+#pragma GCC unroll 4
+            for (size_t vector = 0; vector < VECTOR_COUNT; ++vector) {
+                cells[vector] = _mm512_min_pd(
+                    _mm512_add_pd(from_weight, _mm512_loadu_pd(weights_through + vector * 8)),
+                    cells[vector]);
+            }
+        }
+    }
+
+    // A route to a through vertex that the earlier ones lowered takes its predecessor
+    // the way the cells do below.
+    uint32_t throughs[PANEL_SIZE];
+    for (size_t through = 0; through < PANEL_SIZE; ++through) {
+        throughs[through] = static_cast<uint32_t>(through);
+        const double weight = column_weights[through];
+        column_prevs[through] =
+            weight < weights_row[through]
+                ? FindTileCellPrev(column_weights, column_prevs, through_weights,
+                                   through_prevs, PANEL_SIZE, throughs, through, through,
+                                   weight, no_prev_edge)
+                : prev_row[through];
+    }
+    for (size_t vector = 0; vector < VECTOR_COUNT; ++vector) {
+        unsigned lanes = _mm512_cmp_pd_mask(
+            cells[vector], _mm512_loadu_pd(weights_row + vector * 8), _CMP_LT_OQ);
+        if (lanes == 0) {
+            continue;
+        }
+        _mm512_storeu_pd(weights_row + vector * 8, cells[vector]);
+        for (; lanes != 0; lanes &= lanes - 1) {
+            const size_t cell = vector * 8 + __builtin_ctz(lanes);
+            prev_row[cell] = FindTileCellPrev(column_weights, column_prevs, through_weights,
+                                              through_prevs, PANEL_SIZE, throughs, PANEL_SIZE,
+                                              cell, weights_row[cell], no_prev_edge);
+        }
+    }
+}
+
+#pragma GCC diagnostic pop
+
+// Checked once per process.
+inline bool HasAvx2() {
+    static const bool has_avx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return has_avx2;
+}
+#endif
+
+#if defined(__SSE2__)
+inline size_t
+RelaxRowSse2(double weight_from,
+             uint32_t prev_from,
+             const double *weights_through,
+             const uint32_t *prev_through,
+             double *weights_row,
+             uint32_t *prev_row,
+             size_t begin,
+             size_t end,
+             uint32_t unreachable,
+             uint32_t no_prev_edge) {
+    size_t idx = begin;
+    // SSE2 has no blend instructions, masks select with and/andnot/or instead.
+    const __m128d from_weight = _mm_set1_pd(weight_from);
+    const __m128i from_prev = _mm_set1_epi32(static_cast<int>(prev_from));
+    const __m128i unreachable_prev = _mm_set1_epi32(static_cast<int>(unreachable));
+    const __m128i no_prev = _mm_set1_epi32(static_cast<int>(no_prev_edge));
+    const auto select = [](__m128i mask, __m128i if_set, __m128i if_clear) {
+        return _mm_or_si128(_mm_and_si128(mask, if_set), _mm_andnot_si128(mask, if_clear));
+    };
+    for (; idx + 2 <= end; idx += 2) {
+        const __m128i through_prev =
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(prev_through + idx));
+        const __m128i row_prev =
+            _mm_loadl_epi64(reinterpret_cast<const __m128i *>(prev_row + idx));
+        const __m128d candidate = _mm_add_pd(from_weight, _mm_loadu_pd(weights_through + idx));
+        const __m128d row_weight = _mm_loadu_pd(weights_row + idx);
+
+        const __m128i lighter = _mm_shuffle_epi32(
+            _mm_castpd_si128(_mm_cmplt_pd(candidate, row_weight)), _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128i better = _mm_andnot_si128(
+            _mm_cmpeq_epi32(through_prev, unreachable_prev),
+            _mm_or_si128(_mm_cmpeq_epi32(row_prev, unreachable_prev), lighter));
+        // Only the two low lanes hold cells.
+        if ((_mm_movemask_epi8(better) & 0xFF) == 0) {
+            continue;
+        }
+
+        const __m128i new_prev =
+            select(_mm_cmpeq_epi32(through_prev, no_prev), from_prev, through_prev);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(prev_row + idx),
+                         select(better, new_prev, row_prev));
+        const __m128i better64 = _mm_unpacklo_epi32(better, better);
+        _mm_storeu_pd(weights_row + idx,
+                      _mm_castsi128_pd(select(better64, _mm_castpd_si128(candidate),
+                                              _mm_castpd_si128(row_weight))));
+    }
+    return idx;
+}
+#endif
+
+#if defined(GRAPH_MIN_PLUS_AVX2)
+// Checked once per process.
+inline bool HasAvx512() {
+    static const bool has_avx512 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") != 0;
+    }();
+    return has_avx512;
+}
+#endif
+
+// Whether RelaxTileRowSimd has a kernel on this CPU; the caller prepares the infinite
+// weights only then.
+inline bool HasTileKernel() {
+#if defined(GRAPH_MIN_PLUS_AVX2)
+    return HasAvx2();
+#else
+    return false;
+#endif
+}
+
+// Whether RelaxPanelRowSimd has a kernel on this CPU, which implies HasTileKernel().
+inline bool HasPanelKernel() {
+#if defined(GRAPH_MIN_PLUS_AVX2)
+    return HasAvx2() && HasAvx512();
+#else
+    return false;
+#endif
+}
+
+// Tile stage of the blocked all-pairs precompute with double weights in which an
+// unreachable cell weighs +infinity, so that the weights alone decide every update.
+// The cell_count cells of a row are relaxed through the through_count vertices of
+// throughs in order, those the row reaches: the routes from through vertex k are
+// snapshot row k (through_stride apart) and the route to it is column_weights[k] and
+// column_prevs[k]. Cells stay in registers across the through vertices and only those
+// that improved get a predecessor, so the result is the one of the row kernels applied
+// through vertex by through vertex. Call it only when HasTileKernel() holds.
+inline void RelaxTileRowSimd(const double *column_weights,
+                             const uint32_t *column_prevs,
+                             const double *through_weights,
+                             const uint32_t *through_prevs,
+                             size_t through_stride,
+                             const uint32_t *throughs,
+                             size_t through_count,
+                             double *weights_row,
+                             uint32_t *prev_row,
+                             size_t cell_count,
+                             uint32_t no_prev_edge) {
+#if defined(GRAPH_MIN_PLUS_AVX2)
+    if (HasAvx512()) {
+        RelaxTileRowAvx512(column_weights, column_prevs, through_weights, through_prevs,
+                           through_stride, throughs, through_count, weights_row, prev_row,
+                           cell_count, no_prev_edge);
+        return;
+    }
+    RelaxTileRowAvx2(column_weights, column_prevs, through_weights, through_prevs,
+                     through_stride, throughs, through_count, weights_row, prev_row,
+                     cell_count, no_prev_edge);
+#endif
+}
+
+// Runs the panel kernel on PANEL_SIZE cells whose through rows are PANEL_SIZE apart,
+// with the weights of RelaxTileRowSimd. Call it only when HasPanelKernel() holds.
+inline void RelaxPanelRowSimd(const double *through_weights,
+                              const uint32_t *through_prevs,
+                              double *weights_row,
+                              uint32_t *prev_row,
+                              double *column_weights,
+                              uint32_t *column_prevs,
+                              uint32_t no_prev_edge) {
+#if defined(GRAPH_MIN_PLUS_AVX2)
+    RelaxPanelRowAvx512(through_weights, through_prevs, weights_row, prev_row, column_weights,
+                        column_prevs, no_prev_edge);
+#endif
+}
+
+// Picks the widest kernel the CPU runs; without one the scalar loop does the whole row.
+inline size_t RelaxRowSimd(double weight_from,
+                           uint32_t prev_from,
+                           const double *weights_through,
+                           const uint32_t *prev_through,
+                           double *weights_row,
+                           uint32_t *prev_row,
+                           size_t begin,
+                           size_t end,
+                           uint32_t unreachable,
+                           uint32_t no_prev_edge) {
+#if defined(GRAPH_MIN_PLUS_AVX2)
+    if (HasAvx2()) {
+        return RelaxRowAvx2(weight_from, prev_from, weights_through, prev_through,
+                            weights_row, prev_row, begin, end, unreachable, no_prev_edge);
+    }
+#endif
+#if defined(__SSE2__)
+    return RelaxRowSse2(weight_from, prev_from, weights_through, prev_through, weights_row,
+                        prev_row, begin, end, unreachable, no_prev_edge);
+#else
+    return begin;
+#endif
+}
+
+} // namespace graph::detail
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace router {
+
+// RAPTOR: round k scans, stop by stop, every bus line that serves a stop improved in
+// round k - 1, which gives the fastest journeys with k boardings; the search ends when
+// a round improves nothing. Lines have no timetable, a boarding costs the wait time and
+// a ride the time of its distance. Lines and stops are flat arrays, there is no graph.
+class RaptorRouter {
+  public:
+    using RideTime = double (*)(double distance, double bus_velocity);
+
+    struct Costs {
+        double wait_time{};
+        double bus_velocity{};
+    };
+
+    // A ride of `bus` from bus->route[board] to bus->route[alight].
+    struct Leg {
+        domain::BusPtr bus;
+        size_t board{};
+        size_t alight{};
+        double distance{};
+    };
+
+    struct Journey {
+        double time{};
+        std::vector<Leg> legs;
+    };
+
+  public:
+    RaptorRouter(const tc::TransportCatalogue &catalogue, RideTime ride_time);
+
+    // Stops missing from the catalogue the router was built from are unreachable.
+    std::optional<Journey> BuildRoute(const domain::StopPtr &from,
+                                      const domain::StopPtr &to,
+                                      const Costs &costs) const;
+    std::vector<std::optional<double>>
+    BuildWeights(const domain::StopPtr &from,
+                 const std::vector<domain::StopPtr> &targets,
+                 const Costs &costs) const;
+    // Stops within max_time of `from` with their times.
+    std::vector<std::pair<domain::StopPtr, double>>
+    BuildReachable(const domain::StopPtr &from, double max_time, const Costs &costs) const;
+
+    // Drops the lines of the bus, e.g. before it leaves the catalogue.
+    void RemoveBus(std::string_view name);
+
+    size_t GetLastRoundCount() const {
+        return round_count_;
+    }
+
+  private:
+    // Stops are indexed by their ids in the catalogue.
+    using StopIndex = domain::StopId;
+
+    struct Label {
+        double time;
+        uint32_t route;
+        uint32_t board;
+        uint32_t alight;
+        double distance;
+    };
+
+    std::optional<StopIndex> FindStop(const domain::StopPtr &stop) const;
+    void Search(StopIndex from, StopIndex to, double max_time, const Costs &costs) const;
+    void ScanRoute(uint32_t route, StopIndex to, double max_time, const Costs &costs) const;
+
+    static constexpr double UNREACHED = std::numeric_limits<double>::max();
+    static constexpr uint32_t NO_POSITION = std::numeric_limits<uint32_t>::max();
+    static constexpr StopIndex NO_STOP = std::numeric_limits<StopIndex>::max();
+    static constexpr Label NO_LABEL{UNREACHED, NO_POSITION, NO_POSITION, NO_POSITION, 0};
+
+    RideTime ride_time_;
+    std::vector<domain::StopPtr> stops_;
+    std::vector<domain::BusPtr> buses_;
+    // Route r keeps its stops, and the distances to them from the previous stop, at
+    // [route_offsets_[r], route_offsets_[r + 1]).
+    std::vector<uint32_t> route_offsets_;
+    std::vector<StopIndex> route_stops_;
+    std::vector<double> route_distances_;
+    // Route and position of every visit of stop s at [stop_offsets_[s], stop_offsets_[s + 1]).
+    std::vector<uint32_t> stop_offsets_;
+    std::vector<std::pair<uint32_t, uint32_t>> stop_routes_;
+
+    // Labels of round k are at [k * stop count, (k + 1) * stop count).
+    mutable std::vector<Label> labels_;
+    mutable std::vector<double> best_times_;
+    mutable std::vector<StopIndex> marked_stops_;
+    mutable std::vector<uint32_t> route_starts_;
+    mutable std::vector<uint32_t> queued_routes_;
+    mutable size_t round_count_ = 0;
+};
+
+} // namespace router
@@ -22,7 +22,21 @@ class RequestHandler {
     std::string RenderMap() const;
 
     std::optional<router::RouteInfo> GetRouteInfo(const std::string_view from,
-                                                  const std::string_view to) const;
+                                                  const std::string_view to,
+                                                  const std::string_view profile = {}) const;
+
+    router::TravelTimes GetTravelTimes(const std::vector<std::string_view> &from,
+                                       const std::vector<std::string_view> &to,
+                                       const std::string_view profile = {}) const;
+
+    std::optional<router::ReachableStops>
+    GetReachableStops(const std::string_view from,
+                      const double max_time,
+                      const std::string_view profile = {}) const;
+
+    NearbyStops GetNearbyStops(geo::Coordinates center,
+                               double max_distance,
+                               size_t max_count) const;
 
   private:
     const TransportCatalogue &db_;
@@ -1,129 +1,544 @@
 #pragma once
 
 #include "graph.h"
+#include "min_plus.h"
+#include "thread_pool.h"
 
 #include <algorithm>
-#include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <optional>
+#include <queue>
 #include <stdexcept>
-#include <unordered_map>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace graph {
 
 template <typename Weight>
-class Router {
+struct RouteInfo {
+    Weight weight;
+    std::vector<EdgeId> edges;
+};
+
+// How the all-pairs table is filled. PARALLEL splits every vertex_through phase
+// across rows, BLOCKED also tiles the matrix so the working set stays in cache.
+// All of them produce bit-identical tables.
+enum class RoutesPrecompute {
+    SEQUENTIAL,
+    PARALLEL,
+    BLOCKED,
+};
+
+template <typename Weight>
+class IRouter {
+  public:
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    virtual ~IRouter() = default;
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+
+    // Route weights from one vertex to many, without the edge lists. Engines that can
+    // answer all targets with one search or one table row override it.
+    virtual std::vector<std::optional<Weight>>
+    BuildWeights(VertexId from, const std::vector<VertexId> &targets) const {
+        std::vector<std::optional<Weight>> weights;
+        weights.reserve(targets.size());
+        for (const VertexId to : targets) {
+            const auto route = BuildRoute(from, to);
+            weights.push_back(route ? std::optional<Weight>(route->weight) : std::nullopt);
+        }
+        return weights;
+    }
+};
+
+template <typename Weight>
+class Router : public IRouter<Weight> {
   private:
     using Graph = DirectedWeightedGraph<Weight>;
 
   public:
-    struct RouteInfo {
-        Weight weight;
-        std::vector<EdgeId> edges;
-    };
+    using RouteInfo = typename IRouter<Weight>::RouteInfo;
 
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
+    // Flat V x V table, cell (from, to) lives at from * vertex_count + to. prev_edges
+    // holds the last edge of the route, NO_PREV_EDGE when from == to and UNREACHABLE
+    // when there is no route at all.
+    struct RoutesInternalData {
+        static constexpr uint32_t NO_PREV_EDGE = std::numeric_limits<uint32_t>::max() - 1;
+        static constexpr uint32_t UNREACHABLE = std::numeric_limits<uint32_t>::max();
+
+        size_t vertex_count = 0;
+        std::vector<Weight> weights;
+        std::vector<uint32_t> prev_edges;
+
+        size_t GetIndex(VertexId from, VertexId to) const {
+            return from * vertex_count + to;
+        }
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
 
   public:
-    explicit Router(const Graph &graph);
-    explicit Router(const Graph &graph, const RoutesInternalData &internal_data);
+    explicit Router(const Graph &graph,
+                    RoutesPrecompute precompute = RoutesPrecompute::SEQUENTIAL,
+                    size_t thread_count = 0);
+    explicit Router(const Graph &graph, RoutesInternalData internal_data);
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::vector<std::optional<Weight>>
+    BuildWeights(VertexId from, const std::vector<VertexId> &targets) const override;
     const RoutesInternalData &GetRoutesInternalData() const {
         return routes_internal_data_;
     }
 
+    // Repairs the table after the graph changed in place: vertices may have been
+    // appended, edges in `decreased` added or made lighter, edges in `increased`
+    // removed or made heavier. Rows whose shortest path tree uses an increased edge are
+    // rebuilt with Dijkstra, then every decreased edge is relaxed into all rows.
+    void Update(const std::vector<EdgeId> &decreased, const std::vector<EdgeId> &increased);
+
   private:
+    static constexpr uint32_t NO_PREV_EDGE = RoutesInternalData::NO_PREV_EDGE;
+    static constexpr uint32_t UNREACHABLE = RoutesInternalData::UNREACHABLE;
+
     void InitializeRoutesInternalData(const Graph &graph) {
         const size_t vertex_count = graph.GetVertexCount();
+        if (graph.GetEdgeCount() >= NO_PREV_EDGE) {
+            throw std::length_error("Too many edges for the routes table");
+        }
+        auto &data = routes_internal_data_;
+        data.vertex_count = vertex_count;
+        data.weights.assign(vertex_count * vertex_count, ZERO_WEIGHT);
+        data.prev_edges.assign(vertex_count * vertex_count, UNREACHABLE);
+
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] =
-                RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            data.prev_edges[data.GetIndex(vertex, vertex)] = NO_PREV_EDGE;
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto &edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edge's weights should be non-negative");
                 }
-                auto &route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                const size_t idx = data.GetIndex(vertex, edge.to);
+                if (data.prev_edges[idx] == UNREACHABLE || data.weights[idx] > edge.weight) {
+                    data.weights[idx] = edge.weight;
+                    data.prev_edges[idx] = static_cast<uint32_t>(edge_id);
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from,
-                    VertexId vertex_to,
-                    const RouteInternalData &route_from,
-                    const RouteInternalData &route_to) {
-        auto &route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    // Min-plus update of row [begin, end) through one vertex: the route to that vertex
+    // is (weight_from, prev_from), the routes from it are weights_through/prev_through.
+    // Double weights go through the SIMD kernel, the scalar loop does the rest.
+    static void RelaxRow(Weight weight_from,
+                         uint32_t prev_from,
+                         const Weight *weights_through,
+                         const uint32_t *prev_through,
+                         Weight *weights_row,
+                         uint32_t *prev_row,
+                         size_t begin,
+                         size_t end) {
+        size_t idx = begin;
+        if constexpr (std::is_same_v<Weight, double>) {
+            idx = detail::RelaxRowSimd(weight_from, prev_from, weights_through, prev_through,
+                                       weights_row, prev_row, begin, end, UNREACHABLE,
+                                       NO_PREV_EDGE);
         }
+        for (; idx < end; ++idx) {
+            if (prev_through[idx] == UNREACHABLE) {
+                continue;
+            }
+            const Weight candidate_weight = weight_from + weights_through[idx];
+            if (prev_row[idx] == UNREACHABLE || candidate_weight < weights_row[idx]) {
+                weights_row[idx] = candidate_weight;
+                prev_row[idx] =
+                    prev_through[idx] != NO_PREV_EDGE ? prev_through[idx] : prev_from;
+            }
+        }
+    }
+
+    void RelaxRowThroughVertex(VertexId vertex_from,
+                               VertexId vertex_through,
+                               VertexId vertex_to_begin,
+                               VertexId vertex_to_end) {
+        auto &data = routes_internal_data_;
+        const size_t idx = data.GetIndex(vertex_from, vertex_through);
+        if (data.prev_edges[idx] == UNREACHABLE) {
+            return;
+        }
+        const size_t row_from = data.GetIndex(vertex_from, 0);
+        const size_t row_through = data.GetIndex(vertex_through, 0);
+        RelaxRow(data.weights[idx], data.prev_edges[idx], &data.weights[row_through],
+                 &data.prev_edges[row_through], &data.weights[row_from],
+                 &data.prev_edges[row_from], vertex_to_begin, vertex_to_end);
     }
 
     void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
         for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto &route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto &route_to =
-                            routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+            RelaxRowThroughVertex(vertex_from, vertex_through, 0, vertex_count);
+        }
+    }
+
+    // Phase vertex_through never changes its own row and column (the diagonal is zero and
+    // weights are non-negative), so the rows of one phase can be relaxed concurrently.
+    void RelaxRoutesInternalDataParallel(size_t vertex_count, parallel::ThreadPool &pool) {
+        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+            pool.ParallelFor(
+                0, vertex_count,
+                [this, vertex_count, vertex_through](VertexId vertex_from) {
+                    RelaxRowThroughVertex(vertex_from, vertex_through, 0, vertex_count);
+                },
+                ROWS_GRAIN);
+        }
+    }
+
+    // Blocked Floyd-Warshall that keeps the exact per-cell update order of the sequential
+    // loop. For a block of BLOCK_SIZE through-vertices, the rows of the block are advanced
+    // one phase at a time and each row through is snapshotted before its phase. A row
+    // outside the block reads only the snapshots within the block columns, so it runs all
+    // the phases of the block at once, and the routes to the block vertices it takes at
+    // their turns are snapshotted as well. The rest of the matrix is then relaxed tile by
+    // tile against the snapshots, which hold exactly the values the sequential loop reads.
+    //
+    // With the SIMD kernels, unreachable cells weigh +infinity until the end, so the
+    // kernels compare weights only and write predecessors of improved cells only.
+    void RelaxRoutesInternalDataBlocked(size_t vertex_count, parallel::ThreadPool &pool) {
+        auto &data = routes_internal_data_;
+        bool use_tile_kernel = false;
+        bool use_panel_kernel = false;
+        if constexpr (std::is_same_v<Weight, double>) {
+            use_tile_kernel = detail::HasTileKernel();
+            use_panel_kernel = BLOCK_SIZE == detail::PANEL_SIZE && detail::HasPanelKernel();
+        }
+        if (use_tile_kernel) {
+            SetUnreachableWeights(std::numeric_limits<Weight>::infinity());
+        }
+        const size_t tile_count = (vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        // Row snapshots go tile by tile, so that the snapshot rows of a tile are
+        // BLOCK_SIZE apart.
+        const auto snapshot_index = [](size_t offset, VertexId vertex_to) {
+            return (vertex_to / BLOCK_SIZE * BLOCK_SIZE + offset) * BLOCK_SIZE +
+                   vertex_to % BLOCK_SIZE;
+        };
+        std::vector<Weight> row_weights(tile_count * BLOCK_SIZE * BLOCK_SIZE);
+        std::vector<uint32_t> row_prev_edges(tile_count * BLOCK_SIZE * BLOCK_SIZE);
+        std::vector<Weight> column_weights(vertex_count * BLOCK_SIZE);
+        std::vector<uint32_t> column_prev_edges(vertex_count * BLOCK_SIZE);
+        // The offsets of the block vertices each row reaches, for the tiles to skip the
+        // others.
+        std::vector<uint32_t> column_throughs(vertex_count * BLOCK_SIZE);
+        std::vector<size_t> column_through_counts(vertex_count);
+
+        for (VertexId block_begin = 0; block_begin < vertex_count; block_begin += BLOCK_SIZE) {
+            const VertexId block_end = std::min(vertex_count, block_begin + BLOCK_SIZE);
+            const size_t block_width = block_end - block_begin;
+            const auto in_block = [block_begin, block_end](VertexId vertex) {
+                return block_begin <= vertex && vertex < block_end;
+            };
+
+            for (VertexId vertex_through = block_begin; vertex_through < block_end;
+                 ++vertex_through) {
+                const size_t offset = vertex_through - block_begin;
+                const size_t row_through = data.GetIndex(vertex_through, 0);
+                for (VertexId column_begin = 0; column_begin < vertex_count;
+                     column_begin += BLOCK_SIZE) {
+                    const size_t count = std::min(BLOCK_SIZE, vertex_count - column_begin);
+                    const size_t snapshot_idx = snapshot_index(offset, column_begin);
+                    std::copy_n(&data.weights[row_through + column_begin], count,
+                                &row_weights[snapshot_idx]);
+                    std::copy_n(&data.prev_edges[row_through + column_begin], count,
+                                &row_prev_edges[snapshot_idx]);
+                }
+                pool.ParallelFor(
+                    block_begin, block_end,
+                    [&](VertexId vertex_from) {
+                        RelaxRowThroughVertex(vertex_from, vertex_through, 0, vertex_count);
+                    },
+                    ROWS_GRAIN);
+            }
+
+            const Weight *block_weights = &row_weights[snapshot_index(0, block_begin)];
+            const uint32_t *block_prev_edges = &row_prev_edges[snapshot_index(0, block_begin)];
+            pool.ParallelFor(
+                0, vertex_count,
+                [&](VertexId vertex_from) {
+                    if (in_block(vertex_from)) {
+                        return;
+                    }
+                    const size_t row_from = data.GetIndex(vertex_from, block_begin);
+                    Weight *weights_row = &data.weights[row_from];
+                    uint32_t *prev_row = &data.prev_edges[row_from];
+                    Weight *column_weights_row = &column_weights[vertex_from * BLOCK_SIZE];
+                    uint32_t *column_prevs_row = &column_prev_edges[vertex_from * BLOCK_SIZE];
+                    if (use_panel_kernel && block_width == BLOCK_SIZE) {
+                        if constexpr (std::is_same_v<Weight, double>) {
+                            detail::RelaxPanelRowSimd(
+                                block_weights, block_prev_edges, weights_row, prev_row,
+                                column_weights_row, column_prevs_row, NO_PREV_EDGE);
+                        }
+                    } else {
+                        for (size_t offset = 0; offset < block_width; ++offset) {
+                            column_weights_row[offset] = weights_row[offset];
+                            column_prevs_row[offset] = prev_row[offset];
+                            if (prev_row[offset] == UNREACHABLE) {
+                                continue;
+                            }
+                            RelaxRow(weights_row[offset], prev_row[offset],
+                                     block_weights + offset * BLOCK_SIZE,
+                                     block_prev_edges + offset * BLOCK_SIZE, weights_row,
+                                     prev_row, 0, block_width);
+                        }
                     }
+
+                    uint32_t *throughs = &column_throughs[vertex_from * BLOCK_SIZE];
+                    size_t &through_count = column_through_counts[vertex_from];
+                    through_count = 0;
+                    for (size_t offset = 0; offset < block_width; ++offset) {
+                        if (column_prevs_row[offset] != UNREACHABLE) {
+                            throughs[through_count++] = static_cast<uint32_t>(offset);
+                        }
+                    }
+                },
+                ROWS_GRAIN);
+
+            pool.ParallelFor(0, tile_count, [&](size_t row_tile) {
+                const VertexId row_begin = row_tile * BLOCK_SIZE;
+                const VertexId row_end = std::min(vertex_count, row_begin + BLOCK_SIZE);
+                if (in_block(row_begin)) {
+                    return;
                 }
+                for (VertexId column_begin = 0; column_begin < vertex_count;
+                     column_begin += BLOCK_SIZE) {
+                    if (in_block(column_begin)) {
+                        continue;
+                    }
+                    const size_t column_width =
+                        std::min(BLOCK_SIZE, vertex_count - column_begin);
+                    const Weight *tile_weights = &row_weights[snapshot_index(0, column_begin)];
+                    const uint32_t *tile_prev_edges =
+                        &row_prev_edges[snapshot_index(0, column_begin)];
+                    for (VertexId vertex_from = row_begin; vertex_from < row_end;
+                         ++vertex_from) {
+                        const size_t row_from = data.GetIndex(vertex_from, column_begin);
+                        const Weight *column_weights_row =
+                            &column_weights[vertex_from * BLOCK_SIZE];
+                        const uint32_t *column_prevs_row =
+                            &column_prev_edges[vertex_from * BLOCK_SIZE];
+                        const uint32_t *throughs = &column_throughs[vertex_from * BLOCK_SIZE];
+                        const size_t through_count = column_through_counts[vertex_from];
+                        if constexpr (std::is_same_v<Weight, double>) {
+                            if (use_tile_kernel) {
+                                detail::RelaxTileRowSimd(
+                                    column_weights_row, column_prevs_row, tile_weights,
+                                    tile_prev_edges, BLOCK_SIZE, throughs, through_count,
+                                    &data.weights[row_from], &data.prev_edges[row_from],
+                                    column_width, NO_PREV_EDGE);
+                                continue;
+                            }
+                        }
+                        for (size_t idx = 0; idx < through_count; ++idx) {
+                            const size_t offset = throughs[idx];
+                            RelaxRow(column_weights_row[offset], column_prevs_row[offset],
+                                     tile_weights + offset * BLOCK_SIZE,
+                                     tile_prev_edges + offset * BLOCK_SIZE,
+                                     &data.weights[row_from], &data.prev_edges[row_from], 0,
+                                     column_width);
+                        }
+                    }
+                }
+            });
+        }
+        if (use_tile_kernel) {
+            SetUnreachableWeights(ZERO_WEIGHT);
+        }
+    }
+
+    void SetUnreachableWeights(Weight weight) {
+        auto &data = routes_internal_data_;
+        for (size_t idx = 0; idx < data.weights.size(); ++idx) {
+            if (data.prev_edges[idx] == UNREACHABLE) {
+                data.weights[idx] = weight;
             }
         }
     }
 
+    void ResizeRoutesInternalData(size_t vertex_count) {
+        auto &data = routes_internal_data_;
+        RoutesInternalData resized;
+        resized.vertex_count = vertex_count;
+        resized.weights.assign(vertex_count * vertex_count, ZERO_WEIGHT);
+        resized.prev_edges.assign(vertex_count * vertex_count, UNREACHABLE);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            resized.prev_edges[resized.GetIndex(vertex, vertex)] = NO_PREV_EDGE;
+        }
+        for (VertexId from = 0; from < data.vertex_count; ++from) {
+            std::copy_n(&data.weights[data.GetIndex(from, 0)], data.vertex_count,
+                        &resized.weights[resized.GetIndex(from, 0)]);
+            std::copy_n(&data.prev_edges[data.GetIndex(from, 0)], data.vertex_count,
+                        &resized.prev_edges[resized.GetIndex(from, 0)]);
+        }
+        data = std::move(resized);
+    }
+
+    void RecomputeRow(VertexId vertex_from) {
+        using QueueItem = std::pair<Weight, VertexId>;
+        auto &data = routes_internal_data_;
+        const size_t row = data.GetIndex(vertex_from, 0);
+        std::fill_n(&data.weights[row], data.vertex_count, ZERO_WEIGHT);
+        std::fill_n(&data.prev_edges[row], data.vertex_count, UNREACHABLE);
+        data.prev_edges[row + vertex_from] = NO_PREV_EDGE;
+
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        queue.push({ZERO_WEIGHT, vertex_from});
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weight > data.weights[row + vertex]) {
+                continue;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto &edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = weight + edge.weight;
+                const size_t idx = row + edge.to;
+                if (data.prev_edges[idx] == UNREACHABLE ||
+                    candidate_weight < data.weights[idx]) {
+                    data.weights[idx] = candidate_weight;
+                    data.prev_edges[idx] = static_cast<uint32_t>(edge_id);
+                    queue.push({candidate_weight, edge.to});
+                }
+            }
+        }
+    }
+
+    void RelaxRoutesInternalDataThroughEdge(EdgeId edge_id) {
+        auto &data = routes_internal_data_;
+        const auto &edge = graph_.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edge's weights should be non-negative");
+        }
+        const size_t row_through = data.GetIndex(edge.to, 0);
+        for (VertexId vertex_from = 0; vertex_from < data.vertex_count; ++vertex_from) {
+            const size_t idx = data.GetIndex(vertex_from, edge.from);
+            if (data.prev_edges[idx] == UNREACHABLE) {
+                continue;
+            }
+            const size_t row_from = data.GetIndex(vertex_from, 0);
+            RelaxRow(data.weights[idx] + edge.weight, static_cast<uint32_t>(edge_id),
+                     &data.weights[row_through], &data.prev_edges[row_through],
+                     &data.weights[row_from], &data.prev_edges[row_from], 0,
+                     data.vertex_count);
+        }
+    }
+
     static constexpr Weight ZERO_WEIGHT{};
+    static constexpr size_t BLOCK_SIZE = 32;
+    static constexpr size_t ROWS_GRAIN = 16;
     const Graph &graph_;
     RoutesInternalData routes_internal_data_;
 };
 
 template <typename Weight>
-Router<Weight>::Router(const Graph &graph)
-    : graph_(graph), routes_internal_data_(graph.GetVertexCount(),
-                                           std::vector<std::optional<RouteInternalData>>(
-                                               graph.GetVertexCount())) {
+Router<Weight>::Router(const Graph &graph, RoutesPrecompute precompute, size_t thread_count)
+    : graph_(graph) {
     InitializeRoutesInternalData(graph);
 
     const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    if (precompute == RoutesPrecompute::SEQUENTIAL) {
+        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+        }
+        return;
+    }
+
+    parallel::ThreadPool pool(thread_count);
+    if (precompute == RoutesPrecompute::PARALLEL) {
+        RelaxRoutesInternalDataParallel(vertex_count, pool);
+    } else {
+        RelaxRoutesInternalDataBlocked(vertex_count, pool);
     }
 }
 
 template <typename Weight>
-Router<Weight>::Router(const Graph &graph, const RoutesInternalData &internal_data)
-    : graph_(graph), routes_internal_data_(internal_data) {}
+Router<Weight>::Router(const Graph &graph, RoutesInternalData internal_data)
+    : graph_(graph), routes_internal_data_(std::move(internal_data)) {}
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo>
 Router<Weight>::BuildRoute(VertexId from, VertexId to) const {
-    const auto &route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+    const auto &data = routes_internal_data_;
+    if (from >= data.vertex_count || to >= data.vertex_count) {
+        throw std::out_of_range("Vertex is out of the routes table");
+    }
+    const size_t row = data.GetIndex(from, 0);
+    if (data.prev_edges[row + to] == UNREACHABLE) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
+    const Weight weight = data.weights[row + to];
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge; 
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge) {
+    for (uint32_t edge_id = data.prev_edges[row + to]; edge_id != NO_PREV_EDGE;
+         edge_id = data.prev_edges[row + graph_.GetEdge(edge_id).from]) {
 
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
     return RouteInfo{weight, std::move(edges)};
 }
 
-} // namespace graph
\ No newline at end of file
+template <typename Weight>
+std::vector<std::optional<Weight>>
+Router<Weight>::BuildWeights(VertexId from, const std::vector<VertexId> &targets) const {
+    const auto &data = routes_internal_data_;
+    if (from >= data.vertex_count) {
+        throw std::out_of_range("Vertex is out of the routes table");
+    }
+    const size_t row = data.GetIndex(from, 0);
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(targets.size());
+    for (const VertexId to : targets) {
+        if (to >= data.vertex_count) {
+            throw std::out_of_range("Vertex is out of the routes table");
+        }
+        if (data.prev_edges[row + to] == UNREACHABLE) {
+            weights.push_back(std::nullopt);
+        } else {
+            weights.push_back(data.weights[row + to]);
+        }
+    }
+    return weights;
+}
+
+template <typename Weight>
+void Router<Weight>::Update(const std::vector<EdgeId> &decreased,
+                            const std::vector<EdgeId> &increased) {
+    auto &data = routes_internal_data_;
+    if (graph_.GetEdgeCount() >= NO_PREV_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+
+    // In row from, an edge can only be the last edge of the route to its own head.
+    std::vector<bool> is_stale(data.vertex_count, false);
+    for (const EdgeId edge_id : increased) {
+        const VertexId edge_to = graph_.GetEdge(edge_id).to;
+        for (VertexId vertex_from = 0; vertex_from < data.vertex_count; ++vertex_from) {
+            if (data.prev_edges[data.GetIndex(vertex_from, edge_to)] == edge_id) {
+                is_stale[vertex_from] = true;
+            }
+        }
+    }
+
+    if (graph_.GetVertexCount() > data.vertex_count) {
+        ResizeRoutesInternalData(graph_.GetVertexCount());
+    }
+    for (VertexId vertex_from = 0; vertex_from < is_stale.size(); ++vertex_from) {
+        if (is_stale[vertex_from]) {
+            RecomputeRow(vertex_from);
+        }
+    }
+    for (const EdgeId edge_id : decreased) {
+        RelaxRoutesInternalDataThroughEdge(edge_id);
+    }
+}
+
+} // namespace graph
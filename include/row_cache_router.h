@@ -0,0 +1,131 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "dijkstra_router.h"
+#include "router.h"
+
+#include <algorithm>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace graph {
+
+// Lazy rows of the all-pairs table: the first query from a vertex runs one
+// single-source search and keeps its shortest-path tree, later queries from it are
+// answered from memory. Trees take memory_limit bytes at most, the least recently
+// used one is evicted first; at least one tree is kept whatever the limit.
+template <typename Weight>
+class RowCacheRouter : public IRouter<Weight> {
+  private:
+    using Graph = CsrGraph<Weight>;
+    using Search = DijkstraRouter<Weight>;
+    using Tree = typename Search::Tree;
+
+  public:
+    using RouteInfo = typename IRouter<Weight>::RouteInfo;
+
+  public:
+    RowCacheRouter(const Graph &graph, size_t memory_limit);
+
+    RowCacheRouter(const RowCacheRouter &) = delete;
+    RowCacheRouter &operator=(const RowCacheRouter &) = delete;
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::vector<std::optional<Weight>>
+    BuildWeights(VertexId from, const std::vector<VertexId> &targets) const override;
+
+    size_t GetCapacity() const {
+        return capacity_;
+    }
+    size_t GetCachedRowCount() const {
+        return rows_.size();
+    }
+    // Queries that had to run a search.
+    size_t GetMissCount() const {
+        return miss_count_;
+    }
+
+  private:
+    struct Row {
+        Tree tree;
+        std::list<VertexId>::iterator position;
+    };
+
+    const Tree &GetTree(VertexId from) const;
+
+    // Tail of every edge id, to walk the trees back.
+    std::vector<VertexId> edge_sources_;
+    Search search_;
+    size_t capacity_;
+    // Sources from the most to the least recently used.
+    mutable std::list<VertexId> recent_sources_;
+    mutable std::unordered_map<VertexId, Row> rows_;
+    mutable size_t miss_count_ = 0;
+};
+
+template <typename Weight>
+RowCacheRouter<Weight>::RowCacheRouter(const Graph &graph, size_t memory_limit)
+    : edge_sources_(graph.GetEdgeCount()), search_(graph) {
+    for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+        for (size_t arc = graph.GetArcsBegin(vertex); arc < graph.GetArcsEnd(vertex); ++arc) {
+            edge_sources_[graph.GetEdgeId(arc)] = vertex;
+        }
+    }
+    const size_t row_size =
+        std::max<size_t>(1, graph.GetVertexCount() * (sizeof(Weight) + sizeof(EdgeId)));
+    capacity_ = std::max<size_t>(1, memory_limit / row_size);
+}
+
+template <typename Weight>
+const typename RowCacheRouter<Weight>::Tree &
+RowCacheRouter<Weight>::GetTree(VertexId from) const {
+    if (const auto it = rows_.find(from); it != rows_.end()) {
+        recent_sources_.splice(recent_sources_.begin(), recent_sources_, it->second.position);
+        return it->second.tree;
+    }
+
+    ++miss_count_;
+    if (rows_.size() == capacity_) {
+        rows_.erase(recent_sources_.back());
+        recent_sources_.pop_back();
+    }
+    recent_sources_.push_front(from);
+    return rows_.emplace(from, Row{search_.BuildTree(from), recent_sources_.begin()})
+        .first->second.tree;
+}
+
+template <typename Weight>
+std::optional<typename RowCacheRouter<Weight>::RouteInfo>
+RowCacheRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const Tree &tree = GetTree(from);
+    if (tree.weights[to] == Search::UNREACHED) {
+        return std::nullopt;
+    }
+
+    RouteInfo route{tree.weights[to], {}};
+    for (EdgeId edge_id = tree.prev_edges[to]; edge_id != Search::NO_EDGE;
+         edge_id = tree.prev_edges[edge_sources_[edge_id]]) {
+        route.edges.push_back(edge_id);
+    }
+    std::reverse(route.edges.begin(), route.edges.end());
+    return route;
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>>
+RowCacheRouter<Weight>::BuildWeights(VertexId from,
+                                     const std::vector<VertexId> &targets) const {
+    const Tree &tree = GetTree(from);
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(targets.size());
+    for (const VertexId to : targets) {
+        weights.push_back(tree.weights[to] != Search::UNREACHED
+                              ? std::optional<Weight>(tree.weights[to])
+                              : std::nullopt);
+    }
+    return weights;
+}
+
+} // namespace graph
@@ -24,29 +24,67 @@ class Serializer {
 
     tc::TransportCatalogue GetTransportCatalogue();
     const renderer::RendererSettings GetRendererSettings();
-    const router::Graph GetRouterGraph();
+    const router::RoutingSettings GetRoutingSettings();
+    const router::CsrGraph GetRouterGraph();
     const router::EdgesInfo GetRouterEdgesInfo();
+    const router::BusEdgeIds GetRouterBusEdges();
     const router::StopVertexes GetRouterVertexes();
-    const router::Router::RoutesInternalData GetRouterInternalData();
+    graph::ComponentIndex::Data GetRouterComponents();
+    router::RouterData GetRouterData();
+    router::ProfilesData GetProfilesData();
 
   private:
     const proto::TransportCatalogue
     SerializeTransportCatalogue(const tc::TransportCatalogue &);
-    void SerializeStops(proto::TransportCatalogue &, const domain::StopPtrSet &);
-    void SerializeBuses(proto::TransportCatalogue &, const domain::BusPtrSet &);
-    void SerializeDistances(proto::TransportCatalogue &, const tc::StopsDist &);
+    // Stops and buses are written in id order, so a stop's index in the base is its id.
+    void SerializeStops(proto::TransportCatalogue &, const tc::TransportCatalogue &);
+    void SerializeBuses(proto::TransportCatalogue &, const tc::TransportCatalogue &);
+    void SerializeDistances(proto::TransportCatalogue &, const tc::TransportCatalogue &);
 
-    const proto::TransportRouter SerializeTransportRouter(const router::TransportRouter &);
+    // Both proto::TransportRouter and its ProfileData hold the router data, under the
+    // same field names.
+    template <typename Message>
+    router::RouterData GetRouterData(const Message &);
+    template <typename Message>
+    router::Router::RoutesInternalData GetRouterInternalData(const Message &);
+    template <typename Message>
+    router::ContractionHierarchy::Data GetContractionHierarchy(const Message &);
+    template <typename Message>
+    router::LandmarkRouter::Data GetLandmarks(const Message &);
+    template <typename Message>
+    router::HubLabels::Data GetHubLabels(const Message &);
+
+    const proto::TransportRouter SerializeTransportRouter(const tc::TransportCatalogue &,
+                                                          const router::TransportRouter &);
     void SerializeGraph(proto::TransportRouter &, const router::TransportRouter &);
-    void SerializeRouteInternalData(proto::TransportRouter &, const router::TransportRouter &);
+    void SerializeComponents(proto::TransportRouter &, const router::TransportRouter &);
+    template <typename Message>
+    void SerializeRouterData(Message &,
+                             const router::TransportRouter &,
+                             std::string_view profile = {});
+    template <typename Message>
+    void SerializeRouteInternalData(Message &,
+                                    const router::Router::RoutesInternalData *,
+                                    const graph::ComponentIndex &);
+    template <typename Message>
+    void SerializeContractionHierarchy(Message &, const router::ContractionHierarchy::Data *);
+    template <typename Message>
+    void SerializeLandmarks(Message &, const router::LandmarkRouter::Data *);
+    template <typename Message>
+    void SerializeHubLabels(Message &, const router::HubLabels::Data *);
     void SerializeRouteInfo(proto::TransportRouter &, const router::TransportRouter &);
     void SerializeVertexes(proto::TransportRouter &, const router::TransportRouter &);
+    void SerializeBusEdges(proto::TransportRouter &,
+                           const tc::TransportCatalogue &,
+                           const router::TransportRouter &);
+    void SerializeRoutingSettings(proto::TransportRouter &, const router::RoutingSettings &);
 
     const proto::RenderSettings SerializeRenderSettings(const renderer::RendererSettings &);
 
     void DeserializeStops(tc::TransportCatalogue &);
     void DeserializeBuses(tc::TransportCatalogue &);
     void DeserializeDistances(tc::TransportCatalogue &);
+    void DeserializeBusStats(tc::TransportCatalogue &);
     svg::Color DeserializeColor(const proto::Color &);
 
   private:
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "geo.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace geo {
+
+// Implicit k-d tree over points: the point of a range [begin, end) is the median at
+// (begin + end) / 2 by latitude at even depths and by longitude at odd ones, the
+// halves are the subtrees. The tree is only an order of the point ids, so it is stored
+// as that order. A subtree is skipped when a lower bound of the distance to its side of
+// the split is beyond the current search radius.
+class SpatialIndex {
+  public:
+    struct Neighbour {
+        uint32_t id;
+        double distance;
+    };
+
+    static constexpr double NO_LIMIT = std::numeric_limits<double>::infinity();
+
+  public:
+    SpatialIndex() = default;
+    explicit SpatialIndex(const std::vector<Coordinates> &points);
+    // The tree given by its order of ids, as GetOrder returns it.
+    SpatialIndex(const std::vector<Coordinates> &points, std::vector<uint32_t> order);
+
+    // Points at most max_distance metres away from center, max_count of them at most,
+    // nearest first and by id among equals.
+    std::vector<Neighbour> FindNearest(Coordinates center,
+                                       double max_distance = NO_LIMIT,
+                                       size_t max_count = std::numeric_limits<size_t>::max())
+        const;
+
+    size_t GetPointCount() const {
+        return order_.size();
+    }
+    const std::vector<uint32_t> &GetOrder() const {
+        return order_;
+    }
+
+  private:
+    void Build(size_t begin, size_t end, size_t depth);
+    void FindLongitudeRange();
+    double GetSplitBound(Coordinates center, double split, size_t depth) const;
+
+    std::vector<uint32_t> order_;
+    // Coordinates of the points in the order of the tree.
+    std::vector<Coordinates> points_;
+    double min_lng_ = 0.0;
+    double max_lng_ = 0.0;
+};
+
+} // namespace geo
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// Fixed set of worker threads that run one index range at a time. The calling
+// thread takes part in the work and ParallelFor returns once the range is done.
+class ThreadPool {
+  public:
+    using RangeTask = std::function<void(size_t begin, size_t end)>;
+
+  public:
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t GetThreadCount() const {
+        return workers_.size() + 1;
+    }
+
+    template <typename Func>
+    void ParallelFor(size_t begin, size_t end, Func func, size_t grain = 1) {
+        Run(begin, end, grain, [&func](size_t range_begin, size_t range_end) {
+            for (size_t idx = range_begin; idx < range_end; ++idx) {
+                func(idx);
+            }
+        });
+    }
+
+    void Run(size_t begin, size_t end, size_t grain, const RangeTask &task);
+
+  private:
+    void WorkerLoop();
+    void RunChunks();
+
+  private:
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable task_ready_;
+    std::condition_variable task_done_;
+
+    const RangeTask *task_ = nullptr;
+    size_t next_ = 0;
+    size_t end_ = 0;
+    size_t grain_ = 1;
+    size_t generation_ = 0;
+    size_t busy_workers_ = 0;
+    bool stop_ = false;
+};
+
+} // namespace parallel
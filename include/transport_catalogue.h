@@ -1,8 +1,12 @@
 #pragma once
 
+#include "distance_index.h"
 #include "domain.h"
+#include "ranges.h"
+#include "spatial_index.h"
 
 #include <deque>
+#include <limits>
 #include <optional>
 #include <set>
 #include <string>
@@ -12,20 +16,55 @@
 
 namespace tc {
 
-using Stops = std::unordered_map<std::string_view, domain::StopPtr>;
-using Buses = std::unordered_map<std::string_view, domain::BusPtr>;
+using StopIds = std::unordered_map<std::string_view, domain::StopId>;
+using BusIds = std::unordered_map<std::string_view, domain::BusId>;
 using StopToBuses = std::unordered_map<std::string_view, domain::BusPtrSet>;
-using StopsDist = std::unordered_map<std::pair<domain::StopPtr, domain::StopPtr>,
-                                     double,
-                                     domain::detail::StopPtrPairHasher>;
-
+using RouteStops = ranges::Range<std::vector<domain::StopId>::const_iterator>;
+using StopIdRange = ranges::Range<std::vector<domain::StopId>::const_iterator>;
+using BusIdRange = ranges::Range<std::vector<domain::BusId>::const_iterator>;
+// Stop names with the distances to them in metres.
+using NearbyStops = std::vector<std::pair<std::string_view, double>>;
+
+// Stops and buses live in arrays indexed by their ids: names, coordinates and the stop
+// ids of every route are contiguous, and distances are keyed by stop ids. Names are
+// resolved to ids only at the API edge; the shared pointers are kept for the callers
+// that hold on to stops and buses.
 class TransportCatalogue {
 
   private:
-    Stops name_to_stop_;
-    Buses name_to_bus_;
+    StopIds name_to_stop_;
+    BusIds name_to_bus_;
     StopToBuses stop_to_buses_;
-    StopsDist stops_to_distance_;
+    // The distances are the rows of distance_index_ with the pairs set since the last
+    // freeze over them; lookups check the pending pairs first while there are any.
+    mutable DistanceIndex distance_index_;
+    mutable StopsDist pending_distances_;
+
+    std::vector<domain::StopPtr> stops_;
+    std::vector<std::string_view> stop_names_;
+    std::vector<geo::Coordinates> stop_coordinates_;
+
+    // Route of bus b at [route_offsets_[b], route_offsets_[b + 1]) of route_stops_. A
+    // removed bus keeps its id and its route, without a name to find it by.
+    std::vector<domain::BusPtr> buses_;
+    std::vector<bool> is_removed_bus_;
+    std::vector<uint32_t> route_offsets_{0};
+    std::vector<domain::StopId> route_stops_;
+
+    // Statistics of every bus id, computed once routes and distances are loaded. A new
+    // bus or distance makes them stale and they are computed per request again.
+    std::vector<domain::BusStat> bus_stats_;
+    bool is_bus_stats_current_ = false;
+
+    // Ids in name order, sorted on first use after a stop or bus is added or removed.
+    mutable std::vector<domain::StopId> sorted_stops_;
+    mutable bool is_sorted_stops_current_ = true;
+    mutable std::vector<domain::BusId> sorted_buses_;
+    mutable bool is_sorted_buses_current_ = true;
+
+    // Built on first use after a stop is added, unless read from a base.
+    mutable geo::SpatialIndex stop_index_;
+    mutable bool is_stop_index_current_ = true;
 
   public:
     TransportCatalogue(){};
@@ -37,32 +76,99 @@ class TransportCatalogue {
     void AddBus(domain::Bus &bus);
     void AddBus(domain::Bus &&bus);
     void AddBus(domain::BusPtr bus);
+    void RemoveBus(std::string_view name);
 
     domain::StopPtr SearchStop(std::string_view name) const;
     domain::BusPtr SearchBus(std::string_view name) const;
 
-    void
-    SetDistanceBetweenStops(domain::StopPtr from, domain::StopPtr to, const double distance);
+    void SetDistanceBetweenStops(const domain::StopPtr &from,
+                                 const domain::StopPtr &to,
+                                 const double distance);
     void SetDistanceBetweenStops(const std::string_view &from,
                                  const std::string_view &to,
                                  const double distance);
 
-    double GetDistanceBetweenStops(domain::StopPtr from, domain::StopPtr to) const;
-    const StopsDist *GetDistances() const;
+    double GetDistanceBetweenStops(const domain::StopPtr &from,
+                                   const domain::StopPtr &to) const;
+    double GetDistanceBetweenStops(domain::StopId from, domain::StopId to) const;
+    // The distances as they were set; the first call after a change merges the pending
+    // pairs into the rows, as with the sorted views.
+    const DistanceIndex &GetDistanceIndex() const;
+    // Merges the pending pairs once loading is done, so lookups skip them.
+    void FreezeDistances();
+    // The rows read from a base.
+    void SetDistanceIndex(DistanceIndex::Data data);
 
     const std::optional<domain::BusStat> GetBusStat(const std::string_view &bus_name) const;
+    domain::BusStat GetBusStat(domain::BusId bus) const;
+
+    // Fills the statistics table, buses spread over thread_count threads (0 for the
+    // number of cores).
+    void ComputeBusStats(size_t thread_count = 0);
+    // Statistics read from a base, one per bus id.
+    void SetBusStats(std::vector<domain::BusStat> bus_stats);
+    const std::vector<domain::BusStat> &GetBusStats() const {
+        return bus_stats_;
+    }
 
     const domain::BusPtrSet *GetBusesByStop(const std::string_view &stop_name) const;
 
-    const domain::BusPtrSet GetBuses() const;
-    const domain::StopPtrSet GetStops() const;
-    
+    // Stops and live buses in name order. The ranges hold until the next change of the
+    // catalogue; the first call after a change sorts, so it is not for concurrent use.
+    StopIdRange GetSortedStops() const;
+    BusIdRange GetSortedBuses() const;
+    std::vector<domain::BusPtr> GetBuses() const;
+
+    // The index over stop coordinates; the first call after a change builds it, as
+    // with the sorted views.
+    const geo::SpatialIndex &GetStopIndex() const;
+    // The index read from a base, by its order of stop ids.
+    void SetStopIndex(std::vector<domain::StopId> order);
+    // Stops at most max_distance metres from center, max_count of them at most, nearest
+    // first and by id among equals.
+    NearbyStops GetNearbyStops(geo::Coordinates center,
+                               double max_distance = geo::SpatialIndex::NO_LIMIT,
+                               size_t max_count = std::numeric_limits<size_t>::max()) const;
+
     const size_t GetStopsCount() const {
         return name_to_stop_.size();
     }
 
+    std::optional<domain::StopId> GetStopId(std::string_view name) const;
+    std::optional<domain::BusId> GetBusId(std::string_view name) const;
+
+    // Ids run from 0 to the count, removed buses included.
+    size_t GetStopIdCount() const {
+        return stops_.size();
+    }
+    size_t GetBusIdCount() const {
+        return buses_.size();
+    }
+
+    const domain::StopPtr &GetStop(domain::StopId stop) const {
+        return stops_[stop];
+    }
+    std::string_view GetStopName(domain::StopId stop) const {
+        return stop_names_[stop];
+    }
+    const geo::Coordinates &GetStopCoordinates(domain::StopId stop) const {
+        return stop_coordinates_[stop];
+    }
+
+    const domain::BusPtr &GetBus(domain::BusId bus) const {
+        return buses_[bus];
+    }
+    bool IsBusRemoved(domain::BusId bus) const {
+        return is_removed_bus_[bus];
+    }
+    RouteStops GetRouteStops(domain::BusId bus) const {
+        return {route_stops_.begin() + route_offsets_[bus],
+                route_stops_.begin() + route_offsets_[bus + 1]};
+    }
+
   private:
-    bool IsStopInCatalogue(domain::StopPtr stop) const;
+    bool IsStopInCatalogue(const domain::StopPtr &stop) const;
+    domain::BusStat ComputeBusStat(domain::BusId bus) const;
 };
 
-} // namespace tc
\ No newline at end of file
+} // namespace tc
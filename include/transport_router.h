@@ -1,15 +1,81 @@
 #pragma once
 
+#include "components.h"
+#include "contraction_hierarchy.h"
+#include "csr_graph.h"
+#include "dijkstra_router.h"
+#include "hub_labels.h"
+#include "landmark_router.h"
+#include "raptor_router.h"
 #include "router.h"
+#include "row_cache_router.h"
 #include "transport_catalogue.h"
+#include "vertex_order.h"
 
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
 #include <variant>
 
 namespace router {
 
+// STOP_PAIRS joins every pair of stops of a bus with one edge, O(L^2) edges per line.
+// ROUTE_STOPS gives every stop of every line its own vertex: boarding carries the wait
+// time, riding goes stop by stop and alighting is free, so edges are linear in L.
+enum class GraphModel {
+    STOP_PAIRS,
+    ROUTE_STOPS,
+};
+
+// NAME numbers the stop vertices in name order as they are created, CUTHILL_MCKEE
+// renumbers the built graph so that adjacent vertices get close ids.
+enum class VertexOrder {
+    NAME,
+    CUTHILL_MCKEE,
+};
+
+enum class RouterMode {
+    ALL_PAIRS,
+    DIJKSTRA,
+    CONTRACTION_HIERARCHIES,
+    A_STAR,
+    LANDMARKS,
+    RAPTOR,
+    LAZY_ROWS,
+    HUB_LABELS,
+};
+
+// A named alternative to the wait time and velocity of RoutingSettings, e.g. for peak
+// hours. Profiles share the graph and differ in edge weights only.
+struct RoutingProfile {
+    std::string name;
+    int bus_wait_time = 1;
+    double bus_velocity = 1;
+};
+
 struct RoutingSettings {
     int bus_wait_time = 1;
     double bus_velocity = 1;
+    RouterMode mode = RouterMode::ALL_PAIRS;
+    GraphModel graph_model = GraphModel::STOP_PAIRS;
+    VertexOrder vertex_order = VertexOrder::NAME;
+    graph::RoutesPrecompute precompute = graph::RoutesPrecompute::SEQUENTIAL;
+    size_t precompute_threads = 0;
+    bool verify_precompute = false;
+    size_t landmark_count = 16;
+    // Memory cap of the cached rows in LAZY_ROWS mode, per profile.
+    size_t row_cache_megabytes = 64;
+    std::vector<RoutingProfile> profiles;
+};
+
+struct PrecomputeStats {
+    using Duration = std::chrono::duration<double, std::milli>;
+
+    Duration time{};
+    std::optional<Duration> sequential_time;
+    bool identical = true;
 };
 
 struct WaitEdgeInfo {
@@ -21,6 +87,16 @@ struct BusEdgeInfo {
     std::string_view name;
     int span_count{};
     double time{};
+    double distance{};
+};
+
+struct RideEdgeInfo {
+    std::string_view name;
+    double distance{};
+};
+
+struct AlightEdgeInfo {
+    std::string_view name;
 };
 
 struct VertexIds {
@@ -30,27 +106,83 @@ struct VertexIds {
 
 using Time = double;
 using Router = graph::Router<Time>;
+using DijkstraRouter = graph::DijkstraRouter<Time>;
+using ContractionHierarchy = graph::ContractionHierarchy<Time>;
+using LandmarkRouter = graph::LandmarkRouter<Time>;
+using RowCacheRouter = graph::RowCacheRouter<Time>;
+using HubLabels = graph::HubLabels<Time>;
+using RouterPtr = std::unique_ptr<graph::IRouter<Time>>;
+
+// Hub labels with the hierarchy they were built over.
+struct HubLabelsData {
+    ContractionHierarchy::Data hierarchy;
+    HubLabels::Data labels;
+};
+
+using RouterData = std::variant<std::monostate,
+                                Router::RoutesInternalData,
+                                ContractionHierarchy::Data,
+                                LandmarkRouter::Data,
+                                HubLabelsData>;
 using Graph = graph::DirectedWeightedGraph<Time>;
-using EdgeInfo = std::variant<WaitEdgeInfo, BusEdgeInfo>;
-using RouteInfo = std::pair<double, std::vector<EdgeInfo>>;
+using CsrGraph = graph::CsrGraph<Time>;
+// Preprocessing of the profiles, in the order of RoutingSettings::profiles.
+using ProfilesData = std::vector<RouterData>;
+using EdgeInfo = std::variant<WaitEdgeInfo, BusEdgeInfo, RideEdgeInfo, AlightEdgeInfo>;
+using RouteItem = std::variant<WaitEdgeInfo, BusEdgeInfo>;
+using RouteInfo = std::pair<double, std::vector<RouteItem>>;
+using TravelTimes = std::vector<std::vector<std::optional<Time>>>;
+using ReachableStops = std::vector<std::pair<std::string_view, Time>>;
 using EdgesInfo = std::unordered_map<graph::EdgeId, EdgeInfo>;
 using StopVertexes = std::unordered_map<std::string_view, VertexIds>;
+// Edge ids of every bus by BusId, in the order they were built. ROUTE_STOPS lists the
+// boarding and alighting edges of the bus among its ride edges.
+using BusEdgeIds = std::vector<std::vector<graph::EdgeId>>;
 
 class TransportRouter {
   private:
     static constexpr Time TO_MINUTES = (3.6 / 60.0);
+    // Keeps the A* potential below the edge weights despite rounding.
+    static constexpr Time POTENTIAL_SLACK = 1.0 - 1e-9;
 
   public:
     TransportRouter() = default;
     explicit TransportRouter(const tc::TransportCatalogue &, const RoutingSettings &);
 
     explicit TransportRouter(const tc::TransportCatalogue &,
+                             const RoutingSettings &,
                              const StopVertexes &,
                              const EdgesInfo &,
-                             const Graph &,
-                             const Router::RoutesInternalData &);
+                             const BusEdgeIds &,
+                             const CsrGraph &,
+                             graph::ComponentIndex::Data &&,
+                             RouterData &&,
+                             ProfilesData &&profiles_data = {});
+
+    // Incremental updates, made after the catalogue has changed (or, for RemoveBus,
+    // before the bus leaves the catalogue). Only the edges of the touched buses change.
+    void AddBus(std::string_view bus_name);
+    void RemoveBus(std::string_view bus_name);
+    void UpdateDistance(std::string_view from, std::string_view to);
+    // Recomputes every edge weight from the stored distances for new wait time and
+    // velocity, then customizes the hierarchy or landmarks or rebuilds the router. The
+    // graph model and the vertex order can't change, they define the topology.
+    void SetRoutingSettings(const RoutingSettings &settings);
 
-    std::optional<RouteInfo> GetRouteInfo(std::string_view from, std::string_view to) const;
+    // An empty profile name selects the base settings; an unknown profile finds nothing.
+    std::optional<RouteInfo> GetRouteInfo(std::string_view from,
+                                          std::string_view to,
+                                          std::string_view profile = {}) const;
+    // Total times only, one search or table row per origin; unknown stops give nullopt.
+    TravelTimes GetTravelTimes(const std::vector<std::string_view> &from,
+                               const std::vector<std::string_view> &to,
+                               std::string_view profile = {}) const;
+    // Stops reachable from `from` within max_time, ordered by time and name; nullopt for
+    // an unknown stop or profile. One search bounded by max_time, on the graph in every
+    // mode but RAPTOR.
+    std::optional<ReachableStops> GetReachableStops(std::string_view from,
+                                                    Time max_time,
+                                                    std::string_view profile = {}) const;
 
     const EdgesInfo &GetEdgesInfo() const {
         return edges_info_;
@@ -58,27 +190,126 @@ class TransportRouter {
     const RoutingSettings &GetSettings() const {
         return settings_;
     }
-    const Graph &GetGraph() const {
-        return graph_;
+    const BusEdgeIds &GetBusEdgeIds() const {
+        return bus_edge_ids_;
     }
-    const Router::RoutesInternalData &GetRoutesInternalData() const {
-        return router_->GetRoutesInternalData();
+    const CsrGraph &GetCsrGraph() const {
+        return csr_graph_;
     }
+    const graph::ComponentIndex &GetComponents() const {
+        return components_;
+    }
+    // The preprocessing of the base settings or of a profile, null for other modes.
+    const Router::RoutesInternalData *
+    GetRoutesInternalData(std::string_view profile = {}) const;
+    const ContractionHierarchy::Data *
+    GetContractionHierarchy(std::string_view profile = {}) const;
+    const LandmarkRouter::Data *GetLandmarks(std::string_view profile = {}) const;
+    const HubLabels::Data *GetHubLabels(std::string_view profile = {}) const;
     const StopVertexes &GetStopsVertexIds() const {
         return stops_vertex_ids_;
     }
+    const PrecomputeStats &GetPrecomputeStats() const {
+        return precompute_stats_;
+    }
 
   private:
+    // Profiles keep their own weights over the arcs of csr_graph_ and share
+    // edges_info_ and stops_vertex_ids_. Only the engines that read a Graph get a copy
+    // of graph_ with the profile weights. RAPTOR takes the costs per query, so in that
+    // mode profiles keep the settings only.
+    struct Profile {
+        RoutingSettings settings;
+        CsrGraph csr_graph;
+        Graph graph;
+        RouterPtr router;
+        std::unique_ptr<DijkstraRouter> bounded_search;
+    };
+
+    struct BusEdges {
+        std::vector<graph::Edge<Time>> edges;
+        std::vector<BusEdgeInfo> edges_info;
+    };
+
     void InitializeVertexes();
     void InitializeEdges();
+    std::vector<VertexIds> GetStopVertexes() const;
+    BusEdges BuildBusEdges(domain::BusId bus,
+                           const std::vector<VertexIds> &stop_vertexes) const;
+    std::vector<graph::EdgeId> AddBusEdges(domain::BusId bus, const BusEdges &bus_edges);
+    void InitializeRouteStopGraph();
+    void RenumberVertexes();
+    std::vector<graph::EdgeId> AddRouteStopBus(domain::BusId bus,
+                                               const std::vector<VertexIds> &stop_vertexes);
+    std::vector<graph::EdgeId> AddStopVertexes(domain::BusId bus);
+    void UpdateRouter(const std::vector<graph::EdgeId> &decreased,
+                      const std::vector<graph::EdgeId> &increased);
+    void InitializeRouter(RouterData &&router_data = {});
+    void FreezeGraph();
+    void ThawGraph();
+    void InitializeSearch();
+    void InitializeComponents(graph::ComponentIndex::Data &&data = {});
+    void InitializeProfiles(ProfilesData &&profiles_data = {});
+    void UpdateProfiles(const std::vector<graph::EdgeId> &decreased,
+                        const std::vector<graph::EdgeId> &increased,
+                        bool is_same_vertexes);
+    void ReconfigureProfiles(bool is_customizable);
+    RoutingSettings MakeProfileSettings(const RoutingProfile &routing_profile) const;
+    void ReweightProfile(Profile &profile) const;
+    void BuildProfileRouter(Profile &profile, RouterData &&router_data) const;
+    std::optional<RouteInfo> GetRaptorRouteInfo(std::string_view from,
+                                                std::string_view to,
+                                                const RoutingSettings &settings) const;
+    TravelTimes GetRaptorTravelTimes(const std::vector<std::string_view> &from,
+                                     const std::vector<std::string_view> &to,
+                                     const RoutingSettings &settings) const;
+    RouterPtr MakeRouter(const RoutingSettings &settings,
+                         const Graph &graph,
+                         const CsrGraph &csr_graph,
+                         RouterData &&router_data) const;
+    static void Customize(graph::IRouter<Time> &router);
+    // Engines that keep their vertex order or landmarks for new weights or edges.
+    static bool IsCustomizable(RouterMode mode) {
+        return mode == RouterMode::CONTRACTION_HIERARCHIES || mode == RouterMode::HUB_LABELS ||
+               mode == RouterMode::LANDMARKS;
+    }
+    // All-pairs tables and hierarchies read a Graph, the other engines the CsrGraph.
+    static bool NeedsGraph(RouterMode mode) {
+        return mode == RouterMode::ALL_PAIRS || mode == RouterMode::CONTRACTION_HIERARCHIES ||
+               mode == RouterMode::HUB_LABELS;
+    }
+    void ReweightEdges();
+    Time GetEdgeWeight(const EdgeInfo &edge_info, const RoutingSettings &settings) const;
+    // Weights of the arcs of csr_graph_, in arc order.
+    std::vector<Time> GetArcWeights(const RoutingSettings &settings) const;
+    static Time GetRideTime(double distance, double bus_velocity) {
+        return (distance / bus_velocity) * TO_MINUTES;
+    }
+    // Null for an unknown profile.
+    const graph::IRouter<Time> *FindRouter(std::string_view profile) const;
+    const RoutingSettings *FindSettings(std::string_view profile) const;
+    DijkstraRouter::Potential MakeGeoPotential(const CsrGraph &graph) const;
+    void VerifyPrecompute();
 
   private:
     const tc::TransportCatalogue &catalogue_;
-    const RoutingSettings settings_;
-    std::unique_ptr<Router> router_;
+    RoutingSettings settings_;
+    RouterPtr router_;
+    std::unique_ptr<RaptorRouter> raptor_;
+    std::unique_ptr<DijkstraRouter> bounded_search_;
+    // The stop of every `in` vertex, empty for the other vertices.
+    std::vector<std::string_view> vertex_stops_;
     StopVertexes stops_vertex_ids_;
     EdgesInfo edges_info_;
+    BusEdgeIds bus_edge_ids_;
+    // Edited by the incremental updates, and kept between them only for the modes
+    // that need a Graph; empty while released.
     Graph graph_;
+    CsrGraph csr_graph_;
+    // Follows the topology of graph_, shared by the profiles.
+    graph::ComponentIndex components_;
+    std::map<std::string, std::unique_ptr<Profile>, std::less<>> profiles_;
+    PrecomputeStats precompute_stats_;
 };
 
 } // namespace router
\ No newline at end of file
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "csr_graph.h"
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace graph {
+
+// Reverse Cuthill-McKee order over the graph with arcs taken in both directions:
+// breadth-first search from a pseudo-peripheral vertex of every component, neighbours
+// of a vertex in ascending degree, the whole order reversed. Adjacent vertices get
+// close ids, so searches and table rows touch nearby memory. Returns the new id of
+// every vertex.
+template <typename Weight>
+std::vector<VertexId> ComputeReverseCuthillMcKee(const CsrGraph<Weight> &graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (size_t arc = graph.GetArcsBegin(vertex); arc < graph.GetArcsEnd(vertex); ++arc) {
+            ++offsets[vertex + 1];
+            ++offsets[graph.GetTarget(arc) + 1];
+        }
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+    std::vector<uint32_t> neighbours(offsets.back());
+    std::vector<uint32_t> positions(offsets.begin(), offsets.end() - 1);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (size_t arc = graph.GetArcsBegin(vertex); arc < graph.GetArcsEnd(vertex); ++arc) {
+            const VertexId target = graph.GetTarget(arc);
+            neighbours[positions[vertex]++] = static_cast<uint32_t>(target);
+            neighbours[positions[target]++] = static_cast<uint32_t>(vertex);
+        }
+    }
+    const auto get_degree = [&offsets](VertexId vertex) {
+        return offsets[vertex + 1] - offsets[vertex];
+    };
+    const auto by_degree = [&get_degree](uint32_t lhs, uint32_t rhs) {
+        return get_degree(lhs) < get_degree(rhs) ||
+               (get_degree(lhs) == get_degree(rhs) && lhs < rhs);
+    };
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        const auto begin = neighbours.begin();
+        std::sort(begin + offsets[vertex], begin + offsets[vertex + 1], by_degree);
+    }
+
+    std::vector<VertexId> order;
+    order.reserve(vertex_count);
+    std::vector<uint32_t> stamps(vertex_count, 0);
+    uint32_t stamp = 0;
+    // Appends the breadth-first order from `start` to visit_order.
+    const auto search = [&](VertexId start, std::vector<VertexId> &visit_order) {
+        ++stamp;
+        const size_t begin = visit_order.size();
+        visit_order.push_back(start);
+        stamps[start] = stamp;
+        for (size_t idx = begin; idx < visit_order.size(); ++idx) {
+            const VertexId vertex = visit_order[idx];
+            for (uint32_t pos = offsets[vertex]; pos < offsets[vertex + 1]; ++pos) {
+                if (stamps[neighbours[pos]] != stamp) {
+                    stamps[neighbours[pos]] = stamp;
+                    visit_order.push_back(neighbours[pos]);
+                }
+            }
+        }
+    };
+
+    std::vector<bool> is_ordered(vertex_count, false);
+    std::vector<VertexId> component;
+    for (VertexId root = 0; root < vertex_count; ++root) {
+        if (is_ordered[root]) {
+            continue;
+        }
+        // Of the vertices of the lowest degree, the one the search from the first vertex
+        // of the component reaches last stands in for a peripheral one.
+        component.clear();
+        search(root, component);
+        VertexId start = component.back();
+        for (auto it = component.rbegin(); it != component.rend(); ++it) {
+            if (get_degree(*it) < get_degree(start)) {
+                start = *it;
+            }
+        }
+        search(start, order);
+        for (const VertexId vertex : component) {
+            is_ordered[vertex] = true;
+        }
+    }
+
+    std::vector<VertexId> new_ids(vertex_count);
+    for (size_t idx = 0; idx < vertex_count; ++idx) {
+        new_ids[order[idx]] = vertex_count - 1 - idx;
+    }
+    return new_ids;
+}
+
+// The graph with vertex v renamed to new_ids[v]. Edge ids and the order of every
+// incidence list stay, removed edges stay removed.
+template <typename Weight>
+DirectedWeightedGraph<Weight> RenumberVertices(const DirectedWeightedGraph<Weight> &graph,
+                                               const std::vector<VertexId> &new_ids) {
+    std::vector<Edge<Weight>> edges = graph.GetEdges();
+    for (auto &edge : edges) {
+        edge.from = new_ids[edge.from];
+        edge.to = new_ids[edge.to];
+    }
+    std::vector<bool> is_present(edges.size(), false);
+    for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            is_present[edge_id] = true;
+        }
+    }
+
+    DirectedWeightedGraph<Weight> renumbered(graph.GetVertexCount(), edges);
+    for (EdgeId edge_id = 0; edge_id < edges.size(); ++edge_id) {
+        if (!is_present[edge_id]) {
+            renumbered.RemoveEdge(edge_id);
+        }
+    }
+    return renumbered;
+}
+
+} // namespace graph
@@ -0,0 +1,60 @@
+#include "distance_index.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace tc {
+
+using namespace domain;
+
+DistanceIndex::DistanceIndex(Data data) : data_(std::move(data)) {
+    if (data_.stops.size() != data_.distances.size() ||
+        (!data_.offsets.empty() && data_.offsets.back() != data_.stops.size())) {
+        throw std::invalid_argument("Distance rows don't match their stops");
+    }
+}
+
+DistanceIndex::DistanceIndex(const DistanceIndex &index,
+                             const StopsDist &distances,
+                             size_t stop_count) {
+    std::vector<std::pair<std::pair<StopId, StopId>, double>> pairs(distances.begin(),
+                                                                    distances.end());
+    for (StopId from = 0; from < index.GetStopCount(); ++from) {
+        for (uint32_t idx = index.data_.offsets[from]; idx < index.data_.offsets[from + 1];
+             ++idx) {
+            const std::pair<StopId, StopId> stops{from, index.data_.stops[idx]};
+            if (distances.count(stops) == 0) {
+                pairs.push_back({stops, index.data_.distances[idx]});
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    data_.offsets.assign(stop_count + 1, 0);
+    data_.stops.reserve(pairs.size());
+    data_.distances.reserve(pairs.size());
+    for (const auto &[stops, distance] : pairs) {
+        ++data_.offsets[stops.first + 1];
+        data_.stops.push_back(stops.second);
+        data_.distances.push_back(distance);
+    }
+    std::partial_sum(data_.offsets.begin(), data_.offsets.end(), data_.offsets.begin());
+}
+
+std::optional<double> DistanceIndex::Find(StopId from, StopId to) const {
+    if (from >= GetStopCount()) {
+        return std::nullopt;
+    }
+    const auto begin = data_.stops.begin() + data_.offsets[from];
+    const auto end = data_.stops.begin() + data_.offsets[from + 1];
+    const auto it = std::lower_bound(begin, end, to);
+    if (it == end || *it != to) {
+        return std::nullopt;
+    }
+    return data_.distances[it - data_.stops.begin()];
+}
+
+} // namespace tc
@@ -1,5 +1,7 @@
 #include "json_reader.h"
 
+#include <algorithm>
+#include <limits>
 #include <variant>
 
 namespace json::reader {
@@ -88,6 +90,8 @@ void JsonReader::ExecuteBaseRequest(tc::TransportCatalogue &db) const {
 
     AddStops(add_stop_requests, db);
     AddBuses(add_bus_requests, db);
+    db.FreezeDistances();
+    db.ComputeBusStats();
 }
 
 void JsonReader::ExecuteStatRequest(std::ostream &out,
@@ -108,6 +112,12 @@ void JsonReader::ExecuteStatRequest(std::ostream &out,
             response.push_back(GetMap(request, handler));
         } else if (type == "Route"s) {
             response.push_back(GetRoute(request, handler));
+        } else if (type == "Matrix"s) {
+            response.push_back(GetMatrix(request, handler));
+        } else if (type == "Reachable"s) {
+            response.push_back(GetReachable(request, handler));
+        } else if (type == "NearbyStops"s) {
+            response.push_back(GetNearbyStops(request, handler));
         }
     }
     json::Print(json::Document(json::Node(response)), out);
@@ -227,8 +237,8 @@ struct BuildRouteItem {
 json::Node JsonReader::GetRoute(const json::Dict &request,
                                 const tc::RequestHandler &handler) const {
     const auto &id = request.at("id"s).AsInt();
-    const auto &route_info =
-        handler.GetRouteInfo(request.at("from"s).AsString(), request.at("to"s).AsString());
+    const auto &route_info = handler.GetRouteInfo(
+        request.at("from"s).AsString(), request.at("to"s).AsString(), GetProfile(request));
     if (route_info.has_value()) {
         json::Array items;
         for (const auto &item : route_info->second) {
@@ -255,6 +265,120 @@ json::Node JsonReader::GetRoute(const json::Dict &request,
         .Build();
 }
 
+std::string_view JsonReader::GetProfile(const json::Dict &request) {
+    const auto it = request.find("profile"s);
+    return it != request.end() ? std::string_view(it->second.AsString()) : std::string_view{};
+}
+
+json::Node JsonReader::GetMatrix(const json::Dict &request,
+                                 const tc::RequestHandler &handler) const {
+    const auto to_names = [](const json::Array &stops) {
+        std::vector<std::string_view> names;
+        names.reserve(stops.size());
+        for (const auto &stop : stops) {
+            names.push_back(stop.AsString());
+        }
+        return names;
+    };
+    const auto travel_times = handler.GetTravelTimes(to_names(request.at("from"s).AsArray()),
+                                                     to_names(request.at("to"s).AsArray()),
+                                                     GetProfile(request));
+
+    json::Array rows;
+    rows.reserve(travel_times.size());
+    for (const auto &travel_times_row : travel_times) {
+        json::Array row;
+        row.reserve(travel_times_row.size());
+        for (const auto &time : travel_times_row) {
+            row.push_back(time ? json::Node(*time) : json::Node(nullptr));
+        }
+        rows.push_back(std::move(row));
+    }
+    return json::Builder{}
+        .StartDict()
+        .Key("request_id"s)
+        .Value(request.at("id"s).AsInt())
+        .Key("total_times"s)
+        .Value(std::move(rows))
+        .EndDict()
+        .Build();
+}
+
+json::Node JsonReader::GetReachable(const json::Dict &request,
+                                    const tc::RequestHandler &handler) const {
+    const auto &id = request.at("id"s).AsInt();
+    const auto reachable_stops =
+        handler.GetReachableStops(request.at("from"s).AsString(),
+                                  request.at("max_time"s).AsDouble(), GetProfile(request));
+    if (!reachable_stops) {
+        return json::Builder{}
+            .StartDict()
+            .Key("request_id"s)
+            .Value(id)
+            .Key("error_message"s)
+            .Value("not found"s)
+            .EndDict()
+            .Build();
+    }
+
+    json::Array items;
+    items.reserve(reachable_stops->size());
+    for (const auto &[stop_name, time] : *reachable_stops) {
+        items.push_back(json::Builder{}
+                            .StartDict()
+                            .Key("stop_name"s)
+                            .Value(std::string(stop_name))
+                            .Key("time"s)
+                            .Value(time)
+                            .EndDict()
+                            .Build());
+    }
+    return json::Builder{}
+        .StartDict()
+        .Key("request_id"s)
+        .Value(id)
+        .Key("items"s)
+        .Value(std::move(items))
+        .EndDict()
+        .Build();
+}
+
+// Both "radius" and "count" are optional, without them every stop is listed.
+json::Node JsonReader::GetNearbyStops(const json::Dict &request,
+                                      const tc::RequestHandler &handler) const {
+    const auto &id = request.at("id"s).AsInt();
+    const geo::Coordinates center{request.at("latitude"s).AsDouble(),
+                                  request.at("longitude"s).AsDouble()};
+    const auto radius = request.find("radius"s);
+    const auto count = request.find("count"s);
+    const auto nearby_stops = handler.GetNearbyStops(
+        center,
+        radius != request.end() ? radius->second.AsDouble() : geo::SpatialIndex::NO_LIMIT,
+        count != request.end() ? std::max(0, count->second.AsInt())
+                               : std::numeric_limits<size_t>::max());
+
+    json::Array items;
+    items.reserve(nearby_stops.size());
+    for (const auto &[stop_name, distance] : nearby_stops) {
+        items.push_back(json::Builder{}
+                            .StartDict()
+                            .Key("stop_name"s)
+                            .Value(std::string(stop_name))
+                            .Key("distance"s)
+                            .Value(distance)
+                            .EndDict()
+                            .Build());
+    }
+    return json::Builder{}
+        .StartDict()
+        .Key("request_id"s)
+        .Value(id)
+        .Key("items"s)
+        .Value(std::move(items))
+        .EndDict()
+        .Build();
+}
+
 const renderer::RendererSettings JsonReader::GetRendererSettings() {
     if (render_settings_.empty()) {
         return {};
@@ -299,14 +423,111 @@ const std::string JsonReader::GetSerializationSettings() {
     return {};
 }
 
-const router::RoutingSettings JsonReader::GetRoutingSettings() {
-    router::RoutingSettings settings{};
-    if (routing_settings_.count("bus_velocity"s) > 0 &&
-        routing_settings_.count("bus_wait_time"s) > 0) {
+bool JsonReader::HasRoutingSettings() const {
+    return !routing_settings_.empty();
+}
 
+const router::RoutingSettings
+JsonReader::GetRoutingSettings(router::RoutingSettings settings) {
+    if (routing_settings_.count("bus_velocity"s) > 0) {
         settings.bus_velocity = routing_settings_.at("bus_velocity"s).AsDouble();
+    }
+    if (routing_settings_.count("bus_wait_time"s) > 0) {
         settings.bus_wait_time = routing_settings_.at("bus_wait_time"s).AsInt();
     }
+    if (routing_settings_.count("router_mode"s) > 0) {
+        const auto &mode = routing_settings_.at("router_mode"s).AsString();
+        if (mode == "all_pairs"s) {
+            settings.mode = router::RouterMode::ALL_PAIRS;
+        } else if (mode == "dijkstra"s) {
+            settings.mode = router::RouterMode::DIJKSTRA;
+        } else if (mode == "contraction_hierarchies"s) {
+            settings.mode = router::RouterMode::CONTRACTION_HIERARCHIES;
+        } else if (mode == "a_star"s) {
+            settings.mode = router::RouterMode::A_STAR;
+        } else if (mode == "landmarks"s) {
+            settings.mode = router::RouterMode::LANDMARKS;
+        } else if (mode == "raptor"s) {
+            settings.mode = router::RouterMode::RAPTOR;
+        } else if (mode == "lazy_rows"s) {
+            settings.mode = router::RouterMode::LAZY_ROWS;
+        } else if (mode == "hub_labels"s) {
+            settings.mode = router::RouterMode::HUB_LABELS;
+        } else {
+            throw std::logic_error("unknown router mode"s);
+        }
+    }
+    if (routing_settings_.count("graph_model"s) > 0) {
+        const auto &graph_model = routing_settings_.at("graph_model"s).AsString();
+        if (graph_model == "stop_pairs"s) {
+            settings.graph_model = router::GraphModel::STOP_PAIRS;
+        } else if (graph_model == "route_stops"s) {
+            settings.graph_model = router::GraphModel::ROUTE_STOPS;
+        } else {
+            throw std::logic_error("unknown graph model"s);
+        }
+    }
+    if (routing_settings_.count("vertex_order"s) > 0) {
+        const auto &vertex_order = routing_settings_.at("vertex_order"s).AsString();
+        if (vertex_order == "name"s) {
+            settings.vertex_order = router::VertexOrder::NAME;
+        } else if (vertex_order == "cuthill_mckee"s) {
+            settings.vertex_order = router::VertexOrder::CUTHILL_MCKEE;
+        } else {
+            throw std::logic_error("unknown vertex order"s);
+        }
+    }
+    if (routing_settings_.count("precompute"s) > 0) {
+        const auto &precompute = routing_settings_.at("precompute"s).AsString();
+        if (precompute == "sequential"s) {
+            settings.precompute = graph::RoutesPrecompute::SEQUENTIAL;
+        } else if (precompute == "parallel"s) {
+            settings.precompute = graph::RoutesPrecompute::PARALLEL;
+        } else if (precompute == "blocked"s) {
+            settings.precompute = graph::RoutesPrecompute::BLOCKED;
+        } else {
+            throw std::logic_error("unknown precompute mode"s);
+        }
+    }
+    if (routing_settings_.count("precompute_threads"s) > 0) {
+        const int precompute_threads = routing_settings_.at("precompute_threads"s).AsInt();
+        if (precompute_threads < 0) {
+            throw std::logic_error("negative precompute threads"s);
+        }
+        settings.precompute_threads = precompute_threads;
+    }
+    if (routing_settings_.count("verify_precompute"s) > 0) {
+        settings.verify_precompute = routing_settings_.at("verify_precompute"s).AsBool();
+    }
+    if (routing_settings_.count("landmark_count"s) > 0) {
+        const int landmark_count = routing_settings_.at("landmark_count"s).AsInt();
+        if (landmark_count < 0) {
+            throw std::logic_error("negative landmark count"s);
+        }
+        settings.landmark_count = landmark_count;
+    }
+    if (routing_settings_.count("row_cache_megabytes"s) > 0) {
+        const int row_cache_megabytes = routing_settings_.at("row_cache_megabytes"s).AsInt();
+        if (row_cache_megabytes < 0) {
+            throw std::logic_error("negative row cache size"s);
+        }
+        settings.row_cache_megabytes = row_cache_megabytes;
+    }
+    if (routing_settings_.count("profiles"s) > 0) {
+        settings.profiles.clear();
+        for (const auto &[name, profile] : routing_settings_.at("profiles"s).AsDict()) {
+            const auto &profile_settings = profile.AsDict();
+            router::RoutingProfile routing_profile{name, settings.bus_wait_time,
+                                                   settings.bus_velocity};
+            if (profile_settings.count("bus_wait_time"s) > 0) {
+                routing_profile.bus_wait_time = profile_settings.at("bus_wait_time"s).AsInt();
+            }
+            if (profile_settings.count("bus_velocity"s) > 0) {
+                routing_profile.bus_velocity = profile_settings.at("bus_velocity"s).AsDouble();
+            }
+            settings.profiles.push_back(std::move(routing_profile));
+        }
+    }
     return settings;
 }
 
@@ -8,7 +8,7 @@ bool IsZero(double value) {
     return std::abs(value) < EPSILON;
 }
 
-MapRenderer::MapRenderer(const RendererSettings &settings, const domain::BusPtrSet &buses)
+MapRenderer::MapRenderer(const RendererSettings &settings, std::vector<domain::BusPtr> buses)
     : settings_(std::move(settings)), buses_(std::move(buses)) {
 
     for (const auto &bus : buses_) {
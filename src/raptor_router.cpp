@@ -0,0 +1,217 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+
+namespace router {
+
+RaptorRouter::RaptorRouter(const tc::TransportCatalogue &catalogue, RideTime ride_time)
+    : ride_time_(ride_time) {
+    for (domain::StopId stop = 0; stop < catalogue.GetStopIdCount(); ++stop) {
+        stops_.push_back(catalogue.GetStop(stop));
+    }
+    const size_t stop_count = stops_.size();
+
+    route_offsets_.push_back(0);
+    for (const domain::BusId bus_id : catalogue.GetSortedBuses()) {
+        const auto &bus = catalogue.GetBus(bus_id);
+        const auto bus_stops = catalogue.GetRouteStops(bus_id);
+        for (auto it = bus_stops.begin(); it != bus_stops.end(); ++it) {
+            route_stops_.push_back(*it);
+            route_distances_.push_back(
+                it != bus_stops.begin() ? catalogue.GetDistanceBetweenStops(*(it - 1), *it)
+                                        : 0.0);
+        }
+        buses_.push_back(bus);
+        route_offsets_.push_back(route_stops_.size());
+    }
+
+    stop_offsets_.assign(stop_count + 1, 0);
+    for (const StopIndex stop : route_stops_) {
+        ++stop_offsets_[stop + 1];
+    }
+    for (size_t stop = 0; stop < stop_count; ++stop) {
+        stop_offsets_[stop + 1] += stop_offsets_[stop];
+    }
+    stop_routes_.resize(route_stops_.size());
+    std::vector<uint32_t> positions(stop_offsets_.begin(), stop_offsets_.end() - 1);
+    for (uint32_t route = 0; route < buses_.size(); ++route) {
+        for (uint32_t pos = route_offsets_[route]; pos < route_offsets_[route + 1]; ++pos) {
+            const uint32_t position = pos - route_offsets_[route];
+            stop_routes_[positions[route_stops_[pos]]++] = {route, position};
+        }
+    }
+
+    best_times_.assign(stop_count, UNREACHED);
+    route_starts_.assign(buses_.size(), NO_POSITION);
+}
+
+void RaptorRouter::RemoveBus(std::string_view name) {
+    std::vector<std::pair<uint32_t, uint32_t>> stop_routes;
+    stop_routes.reserve(stop_routes_.size());
+    uint32_t begin = 0;
+    for (size_t stop = 0; stop + 1 < stop_offsets_.size(); ++stop) {
+        const uint32_t end = stop_offsets_[stop + 1];
+        for (uint32_t idx = begin; idx < end; ++idx) {
+            if (buses_[stop_routes_[idx].first]->name != name) {
+                stop_routes.push_back(stop_routes_[idx]);
+            }
+        }
+        begin = end;
+        stop_offsets_[stop + 1] = stop_routes.size();
+    }
+    stop_routes_ = std::move(stop_routes);
+}
+
+std::optional<RaptorRouter::StopIndex>
+RaptorRouter::FindStop(const domain::StopPtr &stop) const {
+    if (!stop || stop->id >= stops_.size() || stops_[stop->id] != stop) {
+        return std::nullopt;
+    }
+    return stop->id;
+}
+
+std::optional<RaptorRouter::Journey> RaptorRouter::BuildRoute(const domain::StopPtr &from,
+                                                              const domain::StopPtr &to,
+                                                              const Costs &costs) const {
+    const auto from_index = FindStop(from);
+    const auto to_index = FindStop(to);
+    if (!from_index || !to_index) {
+        return std::nullopt;
+    }
+    Search(*from_index, *to_index, UNREACHED, costs);
+    if (best_times_[*to_index] == UNREACHED) {
+        return std::nullopt;
+    }
+
+    // Times only improve strictly, so exactly one round holds the best label.
+    const size_t stop_count = best_times_.size();
+    size_t round = 0;
+    while (labels_[round * stop_count + *to_index].time != best_times_[*to_index]) {
+        ++round;
+    }
+
+    Journey journey{best_times_[*to_index], {}};
+    for (StopIndex stop = *to_index; round > 0; --round) {
+        const Label &label = labels_[round * stop_count + stop];
+        journey.legs.push_back(
+            {buses_[label.route], label.board, label.alight, label.distance});
+        stop = route_stops_[route_offsets_[label.route] + label.board];
+    }
+    std::reverse(journey.legs.begin(), journey.legs.end());
+    return journey;
+}
+
+std::vector<std::optional<double>>
+RaptorRouter::BuildWeights(const domain::StopPtr &from,
+                           const std::vector<domain::StopPtr> &targets,
+                           const Costs &costs) const {
+    std::vector<std::optional<double>> weights(targets.size());
+    const auto from_index = FindStop(from);
+    if (!from_index) {
+        return weights;
+    }
+    Search(*from_index, NO_STOP, UNREACHED, costs);
+    for (size_t idx = 0; idx < targets.size(); ++idx) {
+        const auto to_index = FindStop(targets[idx]);
+        if (to_index && best_times_[*to_index] != UNREACHED) {
+            weights[idx] = best_times_[*to_index];
+        }
+    }
+    return weights;
+}
+
+std::vector<std::pair<domain::StopPtr, double>>
+RaptorRouter::BuildReachable(const domain::StopPtr &from,
+                             double max_time,
+                             const Costs &costs) const {
+    std::vector<std::pair<domain::StopPtr, double>> reachable;
+    const auto from_index = FindStop(from);
+    if (!from_index) {
+        return reachable;
+    }
+    Search(*from_index, NO_STOP, max_time, costs);
+    for (StopIndex stop = 0; stop < stops_.size(); ++stop) {
+        if (best_times_[stop] <= max_time) {
+            reachable.emplace_back(stops_[stop], best_times_[stop]);
+        }
+    }
+    return reachable;
+}
+
+// Runs rounds until no stop improves. Labels later than max_time are pruned, and with
+// a target those no better than its best time as well.
+void RaptorRouter::Search(StopIndex from,
+                          StopIndex to,
+                          double max_time,
+                          const Costs &costs) const {
+    const size_t stop_count = best_times_.size();
+    std::fill(best_times_.begin(), best_times_.end(), UNREACHED);
+    labels_.assign(stop_count, NO_LABEL);
+    labels_[from].time = 0;
+    best_times_[from] = 0;
+    marked_stops_.assign(1, from);
+    round_count_ = 0;
+
+    while (!marked_stops_.empty()) {
+        ++round_count_;
+        for (const StopIndex stop : marked_stops_) {
+            for (uint32_t idx = stop_offsets_[stop]; idx < stop_offsets_[stop + 1]; ++idx) {
+                const auto [route, position] = stop_routes_[idx];
+                if (route_starts_[route] == NO_POSITION) {
+                    queued_routes_.push_back(route);
+                }
+                route_starts_[route] = std::min(route_starts_[route], position);
+            }
+        }
+        marked_stops_.clear();
+
+        labels_.resize(labels_.size() + stop_count, NO_LABEL);
+        for (const uint32_t route : queued_routes_) {
+            ScanRoute(route, to, max_time, costs);
+            route_starts_[route] = NO_POSITION;
+        }
+        queued_routes_.clear();
+    }
+}
+
+// Rides the route from its first stop marked in the previous round. The trip is the
+// boarding with the earliest time at the current stop: a boarding here replaces it
+// when the previous round reached the stop earlier than the trip minus the wait.
+void RaptorRouter::ScanRoute(uint32_t route,
+                             StopIndex to,
+                             double max_time,
+                             const Costs &costs) const {
+    const size_t stop_count = best_times_.size();
+    const Label *previous = &labels_[(round_count_ - 1) * stop_count];
+    Label *current = &labels_[round_count_ * stop_count];
+    const uint32_t begin = route_offsets_[route];
+    const uint32_t end = route_offsets_[route + 1];
+
+    uint32_t board = NO_POSITION;
+    double board_time = UNREACHED;
+    double distance = 0;
+    for (uint32_t pos = begin + route_starts_[route]; pos < end; ++pos) {
+        const StopIndex stop = route_stops_[pos];
+        double time = UNREACHED;
+        if (board != NO_POSITION) {
+            distance += route_distances_[pos];
+            time = board_time + ride_time_(distance, costs.bus_velocity);
+            const double bound = to != NO_STOP ? std::min(best_times_[stop], best_times_[to])
+                                               : best_times_[stop];
+            if (time < bound && time <= max_time) {
+                if (current[stop].time == UNREACHED) {
+                    marked_stops_.push_back(stop);
+                }
+                current[stop] = {time, route, board, pos - begin, distance};
+                best_times_[stop] = time;
+            }
+        }
+        if (previous[stop].time != UNREACHED && previous[stop].time + costs.wait_time < time) {
+            board = pos - begin;
+            board_time = previous[stop].time + costs.wait_time;
+            distance = 0;
+        }
+    }
+}
+
+} // namespace router
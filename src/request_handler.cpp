@@ -25,13 +25,35 @@ bool RequestHandler::IsStopInCatalogue(const std::string_view &stop_name) const
 }
 
 std::optional<router::RouteInfo>
-RequestHandler::GetRouteInfo(const std::string_view from, const std::string_view to) const {
+RequestHandler::GetRouteInfo(const std::string_view from,
+                             const std::string_view to,
+                             const std::string_view profile) const {
     StopPtr from_stop = db_.SearchStop(from);
     StopPtr to_stop = db_.SearchStop(to);
     if (from_stop != nullptr && to_stop != nullptr) {
-        return router_.GetRouteInfo(from_stop->name, to_stop->name);
+        return router_.GetRouteInfo(from_stop->name, to_stop->name, profile);
     }
     return {};
 }
 
+router::TravelTimes
+RequestHandler::GetTravelTimes(const std::vector<std::string_view> &from,
+                               const std::vector<std::string_view> &to,
+                               const std::string_view profile) const {
+    return router_.GetTravelTimes(from, to, profile);
+}
+
+std::optional<router::ReachableStops>
+RequestHandler::GetReachableStops(const std::string_view from,
+                                  const double max_time,
+                                  const std::string_view profile) const {
+    return router_.GetReachableStops(from, max_time, profile);
+}
+
+NearbyStops RequestHandler::GetNearbyStops(geo::Coordinates center,
+                                           double max_distance,
+                                           size_t max_count) const {
+    return db_.GetNearbyStops(center, max_distance, max_count);
+}
+
 } // namespace tc
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "serialization.h"
 
 #include <fstream>
+#include <optional>
 
 namespace serialize {
 
@@ -27,7 +28,7 @@ void Serializer::Serialize(const tc::TransportCatalogue &catalogue,
                            const router::TransportRouter &router) {
 
     *db_.mutable_catalogue() = std::move(SerializeTransportCatalogue(catalogue));
-    *db_.mutable_router() = std::move(SerializeTransportRouter(router));
+    *db_.mutable_router() = std::move(SerializeTransportRouter(catalogue, router));
     *db_.mutable_render_settings() =
         std::move(SerializeRenderSettings(renderer.GetSettings()));
 }
@@ -35,8 +36,11 @@ void Serializer::Serialize(const tc::TransportCatalogue &catalogue,
 tc::TransportCatalogue Serializer::GetTransportCatalogue() {
     tc::TransportCatalogue catalogue;
     DeserializeStops(catalogue);
+    catalogue.SetStopIndex(
+        {db_.catalogue().stop_index().begin(), db_.catalogue().stop_index().end()});
     DeserializeBuses(catalogue);
     DeserializeDistances(catalogue);
+    DeserializeBusStats(catalogue);
     return catalogue;
 }
 
@@ -63,13 +67,34 @@ const renderer::RendererSettings Serializer::GetRendererSettings() {
     return settings;
 }
 
-const router::Graph Serializer::GetRouterGraph() {
-    std::vector<graph::Edge<router::Time>> edges;
-    edges.reserve(db_.router().graph().edges_size());
-    for (const auto &s_edge : db_.router().graph().edges()) {
-        edges.push_back({s_edge.from(), s_edge.to(), s_edge.weight()});
+const router::RoutingSettings Serializer::GetRoutingSettings() {
+    const auto &s_settings = db_.router().settings();
+    router::RoutingSettings settings;
+    settings.bus_wait_time = s_settings.bus_wait_time();
+    settings.bus_velocity = s_settings.bus_velocity();
+    settings.mode = static_cast<router::RouterMode>(s_settings.mode());
+    settings.graph_model = static_cast<router::GraphModel>(s_settings.graph_model());
+    settings.vertex_order = static_cast<router::VertexOrder>(s_settings.vertex_order());
+    settings.row_cache_megabytes = s_settings.row_cache_megabytes();
+    settings.precompute = static_cast<graph::RoutesPrecompute>(s_settings.precompute());
+    settings.precompute_threads = s_settings.precompute_threads();
+    if (s_settings.landmark_count() > 0) {
+        settings.landmark_count = s_settings.landmark_count();
     }
-    return router::Graph(edges);
+    for (const auto &s_profile : s_settings.profiles()) {
+        settings.profiles.push_back(
+            {s_profile.name(), s_profile.bus_wait_time(), s_profile.bus_velocity()});
+    }
+    return settings;
+}
+
+const router::CsrGraph Serializer::GetRouterGraph() {
+    const auto &s_graph = db_.router().graph();
+    return router::CsrGraph(
+        {s_graph.offsets().begin(), s_graph.offsets().end()},
+        {s_graph.targets().begin(), s_graph.targets().end()},
+        {s_graph.weights().begin(), s_graph.weights().end()},
+        {s_graph.edge_ids().begin(), s_graph.edge_ids().end()}, s_graph.edge_count());
 }
 
 const router::EdgesInfo Serializer::GetRouterEdgesInfo() {
@@ -77,10 +102,20 @@ const router::EdgesInfo Serializer::GetRouterEdgesInfo() {
     edges_info.reserve(db_.router().edges_info_size());
     int id{};
     for (const auto &s_edge : db_.router().edges_info()) {
+        if (s_edge.is_removed_edge()) {
+            ++id;
+            continue;
+        }
         if (s_edge.is_bus_edge()) {
             edges_info[id] =
                 router::BusEdgeInfo{db_.catalogue().buses(s_edge.name_id()).name(),
-                                    s_edge.span_count(), s_edge.time()};
+                                    s_edge.span_count(), s_edge.time(), s_edge.distance()};
+        } else if (s_edge.is_ride_edge()) {
+            edges_info[id] = router::RideEdgeInfo{
+                db_.catalogue().buses(s_edge.name_id()).name(), s_edge.distance()};
+        } else if (s_edge.is_alight_edge()) {
+            edges_info[id] =
+                router::AlightEdgeInfo{db_.catalogue().stops(s_edge.name_id()).name()};
         } else {
             edges_info[id] = router::WaitEdgeInfo{
                 db_.catalogue().stops(s_edge.name_id()).name(), s_edge.time()};
@@ -90,6 +125,16 @@ const router::EdgesInfo Serializer::GetRouterEdgesInfo() {
     return edges_info;
 }
 
+const router::BusEdgeIds Serializer::GetRouterBusEdges() {
+    router::BusEdgeIds bus_edge_ids;
+    bus_edge_ids.reserve(db_.router().bus_edges_size());
+    for (const auto &s_bus_edges : db_.router().bus_edges()) {
+        const auto &s_edge_ids = s_bus_edges.edge_ids();
+        bus_edge_ids.emplace_back(s_edge_ids.begin(), s_edge_ids.end());
+    }
+    return bus_edge_ids;
+}
+
 const router::StopVertexes Serializer::GetRouterVertexes() {
     router::StopVertexes stop_vertex_ids;
     for (const auto &s_stop_vertex : db_.router().stops_vertex_ids()) {
@@ -99,122 +144,315 @@ const router::StopVertexes Serializer::GetRouterVertexes() {
     return stop_vertex_ids;
 }
 
-const router::Router::RoutesInternalData Serializer::GetRouterInternalData() {
-    const int vertex_count = db_.router().routes_internal_data_size();
-    router::Router::RoutesInternalData internal_data(
-        vertex_count,
-        std::vector<std::optional<router::Router::RouteInternalData>>(vertex_count));
-
-    for (int row = 0; row < vertex_count; ++row) {
-        for (int col = 0; col < vertex_count; ++col) {
-            const auto &vertex = db_.router().routes_internal_data(row).row(col);
-            if (vertex.is_prev_edge()) {
-                internal_data[row][col] =
-                    router::Router::RouteInternalData{vertex.weight(), vertex.prev_edge_id()};
-            } else {
-                internal_data[row][col] =
-                    router::Router::RouteInternalData{vertex.weight(), std::nullopt};
-            }
+graph::ComponentIndex::Data Serializer::GetRouterComponents() {
+    const auto &s_components = db_.router().components();
+    return {{s_components.strong().begin(), s_components.strong().end()},
+            {s_components.weak().begin(), s_components.weak().end()}};
+}
+
+// Vertices of every weak component in id order, the column order of its table rows.
+std::vector<std::vector<uint32_t>> GroupByComponent(const std::vector<uint32_t> &weak) {
+    std::vector<std::vector<uint32_t>> components;
+    for (uint32_t vertex = 0; vertex < weak.size(); ++vertex) {
+        if (weak[vertex] >= components.size()) {
+            components.resize(weak[vertex] + 1);
+        }
+        components[weak[vertex]].push_back(vertex);
+    }
+    return components;
+}
+
+router::RouterData Serializer::GetRouterData() {
+    return GetRouterData(db_.router());
+}
+
+router::ProfilesData Serializer::GetProfilesData() {
+    router::ProfilesData profiles_data;
+    for (const auto &s_profile : db_.router().profiles()) {
+        profiles_data.push_back(GetRouterData(s_profile));
+    }
+    return profiles_data;
+}
+
+template <typename Message>
+router::RouterData Serializer::GetRouterData(const Message &s_data) {
+    switch (GetRoutingSettings().mode) {
+    case router::RouterMode::ALL_PAIRS:
+        return GetRouterInternalData(s_data);
+    case router::RouterMode::CONTRACTION_HIERARCHIES:
+        return GetContractionHierarchy(s_data);
+    case router::RouterMode::HUB_LABELS:
+        return router::HubLabelsData{GetContractionHierarchy(s_data), GetHubLabels(s_data)};
+    case router::RouterMode::LANDMARKS:
+        return GetLandmarks(s_data);
+    default:
+        return {};
+    }
+}
+
+template <typename Message>
+router::Router::RoutesInternalData Serializer::GetRouterInternalData(const Message &s_data) {
+    router::Router::RoutesInternalData internal_data;
+    const int offsets_count = db_.router().graph().offsets_size();
+    const size_t vertex_count = offsets_count > 0 ? offsets_count - 1 : 0;
+    internal_data.vertex_count = vertex_count;
+    const auto &s_weights = s_data.route_weights();
+    const auto &s_prev_edges = s_data.route_prev_edges();
+    if (static_cast<size_t>(s_weights.size()) == vertex_count * vertex_count) {
+        internal_data.weights.assign(s_weights.begin(), s_weights.end());
+        internal_data.prev_edges.assign(s_prev_edges.begin(), s_prev_edges.end());
+        return internal_data;
+    }
+
+    internal_data.weights.assign(vertex_count * vertex_count, router::Time{});
+    internal_data.prev_edges.assign(vertex_count * vertex_count,
+                                    router::Router::RoutesInternalData::UNREACHABLE);
+    const auto &s_weak = db_.router().components().weak();
+    const auto components = GroupByComponent({s_weak.begin(), s_weak.end()});
+    int cell = 0;
+    for (size_t from = 0; from < vertex_count; ++from) {
+        for (const uint32_t to : components[s_weak[from]]) {
+            const size_t idx = internal_data.GetIndex(from, to);
+            internal_data.weights[idx] = s_weights[cell];
+            internal_data.prev_edges[idx] = s_prev_edges[cell];
+            ++cell;
         }
     }
     return internal_data;
 }
 
+template <typename Message>
+router::ContractionHierarchy::Data Serializer::GetContractionHierarchy(const Message &s_data) {
+    const auto &s_hierarchy = s_data.contraction_hierarchy();
+    router::ContractionHierarchy::Data hierarchy;
+    hierarchy.ranks.assign(s_hierarchy.ranks().begin(), s_hierarchy.ranks().end());
+
+    hierarchy.shortcuts.reserve(s_hierarchy.shortcuts_size());
+    for (const auto &s_shortcut : s_hierarchy.shortcuts()) {
+        hierarchy.shortcuts.push_back({s_shortcut.from(), s_shortcut.to(), s_shortcut.weight(),
+                                       s_shortcut.first(), s_shortcut.second()});
+    }
+    return hierarchy;
+}
+
+template <typename Message>
+router::LandmarkRouter::Data Serializer::GetLandmarks(const Message &s_data) {
+    const auto &s_landmarks = s_data.landmarks();
+    router::LandmarkRouter::Data landmarks;
+    landmarks.landmarks.assign(s_landmarks.landmarks().begin(), s_landmarks.landmarks().end());
+    landmarks.from_landmarks.assign(s_landmarks.from_landmarks().begin(),
+                                    s_landmarks.from_landmarks().end());
+    landmarks.to_landmarks.assign(s_landmarks.to_landmarks().begin(),
+                                  s_landmarks.to_landmarks().end());
+    return landmarks;
+}
+
+template <typename Message>
+router::HubLabels::Data Serializer::GetHubLabels(const Message &s_data) {
+    const auto get_labels = [](const proto::HubLabels::Labels &s_labels) {
+        router::HubLabels::Labels labels;
+        labels.offsets.assign(s_labels.offsets().begin(), s_labels.offsets().end());
+        labels.hubs.assign(s_labels.hubs().begin(), s_labels.hubs().end());
+        labels.weights.assign(s_labels.weights().begin(), s_labels.weights().end());
+        labels.edges.assign(s_labels.edges().begin(), s_labels.edges().end());
+        return labels;
+    };
+    const auto &s_hub_labels = s_data.hub_labels();
+    return {get_labels(s_hub_labels.forward()), get_labels(s_hub_labels.backward())};
+}
+
 const proto::TransportCatalogue
 Serializer::SerializeTransportCatalogue(const tc::TransportCatalogue &catalogue) {
     proto::TransportCatalogue s_catalogue;
-    SerializeStops(s_catalogue, catalogue.GetStops());
-    SerializeBuses(s_catalogue, catalogue.GetBuses());
-    SerializeDistances(s_catalogue, *catalogue.GetDistances());
+    SerializeStops(s_catalogue, catalogue);
+    SerializeBuses(s_catalogue, catalogue);
+    SerializeDistances(s_catalogue, catalogue);
+    const auto &stop_index = catalogue.GetStopIndex().GetOrder();
+    s_catalogue.mutable_stop_index()->Add(stop_index.begin(), stop_index.end());
     return s_catalogue;
 }
 
 void Serializer::SerializeStops(proto::TransportCatalogue &s_catalogue,
-                                const domain::StopPtrSet &stops) {
-    size_t stop_id = 0;
-    for (const auto &stop : stops) {
+                                const tc::TransportCatalogue &catalogue) {
+    for (domain::StopId stop = 0; stop < catalogue.GetStopIdCount(); ++stop) {
         proto::TransportCatalogue::Stop s_stop;
-        s_stop.set_name(stop->name);
-        s_stop.set_coordinates_lat(stop->coordinates.lat);
-        s_stop.set_coordinates_lng(stop->coordinates.lng);
+        s_stop.set_name(std::string(catalogue.GetStopName(stop)));
+        s_stop.set_coordinates_lat(catalogue.GetStopCoordinates(stop).lat);
+        s_stop.set_coordinates_lng(catalogue.GetStopCoordinates(stop).lng);
 
         *s_catalogue.add_stops() = std::move(s_stop);
-        stop_to_id_[stop->name] = stop_id++;
+        stop_to_id_[catalogue.GetStopName(stop)] = stop;
     }
 }
 
+// Removed buses are left out, so the base numbers buses anew.
 void Serializer::SerializeBuses(proto::TransportCatalogue &s_catalogue,
-                                const domain::BusPtrSet &buses) {
+                                const tc::TransportCatalogue &catalogue) {
     size_t bus_id = 0;
-    for (const auto &bus : buses) {
+    for (domain::BusId bus = 0; bus < catalogue.GetBusIdCount(); ++bus) {
+        if (catalogue.IsBusRemoved(bus)) {
+            continue;
+        }
+        const auto &bus_ptr = catalogue.GetBus(bus);
         proto::TransportCatalogue::Bus s_bus;
-        s_bus.set_name(bus->name);
-        s_bus.set_is_roundtrip(bus->is_roundtrip);
-        s_bus.set_final_stop(stop_to_id_.at(bus->final_stop->name));
-
-        for (const auto &stop : bus->route) {
-            s_bus.add_route(stop_to_id_.at(stop->name));
+        s_bus.set_name(bus_ptr->name);
+        s_bus.set_is_roundtrip(bus_ptr->is_roundtrip);
+        s_bus.set_final_stop(bus_ptr->final_stop->id);
+        for (const domain::StopId stop : catalogue.GetRouteStops(bus)) {
+            s_bus.add_route(stop);
         }
+        const domain::BusStat stat = catalogue.GetBusStat(bus);
+        auto &s_stat = *s_bus.mutable_stat();
+        s_stat.set_stops_on_route(stat.stops_on_route);
+        s_stat.set_unique_stops(stat.unique_stops);
+        s_stat.set_route_length(stat.route_length);
+        s_stat.set_curvature(stat.curvature);
         *s_catalogue.add_buses() = std::move(s_bus);
-        bus_to_id_[bus->name] = bus_id++;
+        bus_to_id_[bus_ptr->name] = bus_id++;
     }
 }
 
+// The distances are written as they were set, the reverse pairs are resolved on lookup.
 void Serializer::SerializeDistances(proto::TransportCatalogue &s_catalogue,
-                                    const tc::StopsDist &distances) {
-    for (const auto &[stops, dist] : distances) {
-        proto::TransportCatalogue::DistanceBetweenStops s_dist;
-        s_dist.set_from_stop_id(stop_to_id_.at(stops.first->name));
-        s_dist.set_to_stop_id(stop_to_id_.at(stops.second->name));
-        s_dist.set_dist(dist);
-
-        *s_catalogue.add_distance() = std::move(s_dist);
-    }
+                                    const tc::TransportCatalogue &catalogue) {
+    const auto &data = catalogue.GetDistanceIndex().GetData();
+    auto &s_distances = *s_catalogue.mutable_distances();
+    s_distances.mutable_offsets()->Add(data.offsets.begin(), data.offsets.end());
+    s_distances.mutable_to_stops()->Add(data.stops.begin(), data.stops.end());
+    s_distances.mutable_dists()->Add(data.distances.begin(), data.distances.end());
 }
 
 const proto::TransportRouter
-Serializer::SerializeTransportRouter(const router::TransportRouter &router) {
+Serializer::SerializeTransportRouter(const tc::TransportCatalogue &catalogue,
+                                     const router::TransportRouter &router) {
     proto::TransportRouter s_router;
     SerializeGraph(s_router, router);
-    SerializeRouteInternalData(s_router, router);
+    SerializeComponents(s_router, router);
+    SerializeRouterData(s_router, router);
+    for (const auto &profile : router.GetSettings().profiles) {
+        SerializeRouterData(*s_router.add_profiles(), router, profile.name);
+    }
     SerializeRouteInfo(s_router, router);
     SerializeVertexes(s_router, router);
+    SerializeBusEdges(s_router, catalogue, router);
+    SerializeRoutingSettings(s_router, router.GetSettings());
     return s_router;
 }
 
 void Serializer::SerializeGraph(proto::TransportRouter &s_router,
                                 const router::TransportRouter &router) {
-    proto::Graph graph;
-    for (const auto &edge : router.GetGraph().GetEdges()) {
-        proto::Graph::Edge s_edge;
-        s_edge.set_from(edge.from);
-        s_edge.set_to(edge.to);
-        s_edge.set_weight(edge.weight);
-        *graph.add_edges() = std::move(s_edge);
-    }
-    *s_router.mutable_graph() = std::move(graph);
-}
-
-void Serializer::SerializeRouteInternalData(proto::TransportRouter &s_router,
-                                            const router::TransportRouter &router) {
-    const auto &internal_data = router.GetRoutesInternalData();
-    for (const auto &internal_data_row : internal_data) {
-        proto::TransportRouter::RouteInternalDataRow s_internal_data_row;
-        for (const auto &internal_data : internal_data_row) {
-            proto::TransportRouter::RouteInternalData s_internal_data;
-            s_internal_data.set_weight(internal_data->weight);
-            if (internal_data->prev_edge.has_value()) {
-                s_internal_data.set_prev_edge_id(internal_data->prev_edge.value());
-                s_internal_data.set_is_prev_edge(true);
-            }
-            *s_internal_data_row.add_row() = std::move(s_internal_data);
+    const auto &graph = router.GetCsrGraph();
+    proto::Graph s_graph;
+    s_graph.mutable_offsets()->Add(graph.GetOffsets().begin(), graph.GetOffsets().end());
+    s_graph.mutable_targets()->Add(graph.GetTargets().begin(), graph.GetTargets().end());
+    s_graph.mutable_weights()->Add(graph.GetWeights().begin(), graph.GetWeights().end());
+    s_graph.mutable_edge_ids()->Add(graph.GetEdgeIds().begin(), graph.GetEdgeIds().end());
+    s_graph.set_edge_count(graph.GetEdgeCount());
+    *s_router.mutable_graph() = std::move(s_graph);
+}
+
+void Serializer::SerializeComponents(proto::TransportRouter &s_router,
+                                     const router::TransportRouter &router) {
+    const auto &components = router.GetComponents().GetData();
+    proto::Components s_components;
+    s_components.mutable_strong()->Add(components.strong.begin(), components.strong.end());
+    s_components.mutable_weak()->Add(components.weak.begin(), components.weak.end());
+    *s_router.mutable_components() = std::move(s_components);
+}
+
+template <typename Message>
+void Serializer::SerializeRouterData(Message &s_data,
+                                     const router::TransportRouter &router,
+                                     std::string_view profile) {
+    SerializeRouteInternalData(s_data, router.GetRoutesInternalData(profile),
+                               router.GetComponents());
+    SerializeContractionHierarchy(s_data, router.GetContractionHierarchy(profile));
+    SerializeLandmarks(s_data, router.GetLandmarks(profile));
+    SerializeHubLabels(s_data, router.GetHubLabels(profile));
+}
+
+template <typename Message>
+void Serializer::SerializeRouteInternalData(
+    Message &s_data,
+    const router::Router::RoutesInternalData *internal_data,
+    const graph::ComponentIndex &component_index) {
+    if (!internal_data) {
+        return;
+    }
+    const auto &weak = component_index.GetData().weak;
+    const auto components = GroupByComponent(weak);
+    auto &s_weights = *s_data.mutable_route_weights();
+    auto &s_prev_edges = *s_data.mutable_route_prev_edges();
+    for (size_t from = 0; from < internal_data->vertex_count; ++from) {
+        for (const uint32_t to : components[weak[from]]) {
+            const size_t idx = internal_data->GetIndex(from, to);
+            s_weights.Add(internal_data->weights[idx]);
+            s_prev_edges.Add(internal_data->prev_edges[idx]);
         }
-        *s_router.add_routes_internal_data() = std::move(s_internal_data_row);
     }
 }
 
-const std::vector<router::EdgeInfo> EdgesInfoToVector(const router::EdgesInfo &edges_info) {
-    std::vector<router::EdgeInfo> edge_info_vec(edges_info.size());
+template <typename Message>
+void Serializer::SerializeContractionHierarchy(
+    Message &s_data, const router::ContractionHierarchy::Data *hierarchy) {
+    if (!hierarchy) {
+        return;
+    }
+    proto::ContractionHierarchy s_hierarchy;
+    for (const auto rank : hierarchy->ranks) {
+        s_hierarchy.add_ranks(rank);
+    }
+    for (const auto &shortcut : hierarchy->shortcuts) {
+        proto::ContractionHierarchy::Shortcut s_shortcut;
+        s_shortcut.set_from(shortcut.from);
+        s_shortcut.set_to(shortcut.to);
+        s_shortcut.set_weight(shortcut.weight);
+        s_shortcut.set_first(shortcut.first);
+        s_shortcut.set_second(shortcut.second);
+        *s_hierarchy.add_shortcuts() = std::move(s_shortcut);
+    }
+    *s_data.mutable_contraction_hierarchy() = std::move(s_hierarchy);
+}
+
+template <typename Message>
+void Serializer::SerializeLandmarks(Message &s_data,
+                                    const router::LandmarkRouter::Data *landmarks) {
+    if (!landmarks) {
+        return;
+    }
+    proto::Landmarks s_landmarks;
+    s_landmarks.mutable_landmarks()->Add(landmarks->landmarks.begin(),
+                                         landmarks->landmarks.end());
+    s_landmarks.mutable_from_landmarks()->Add(landmarks->from_landmarks.begin(),
+                                              landmarks->from_landmarks.end());
+    s_landmarks.mutable_to_landmarks()->Add(landmarks->to_landmarks.begin(),
+                                            landmarks->to_landmarks.end());
+    *s_data.mutable_landmarks() = std::move(s_landmarks);
+}
+
+template <typename Message>
+void Serializer::SerializeHubLabels(Message &s_data,
+                                    const router::HubLabels::Data *hub_labels) {
+    if (!hub_labels) {
+        return;
+    }
+    const auto serialize_labels = [](const router::HubLabels::Labels &labels,
+                                     proto::HubLabels::Labels &s_labels) {
+        s_labels.mutable_offsets()->Add(labels.offsets.begin(), labels.offsets.end());
+        s_labels.mutable_hubs()->Add(labels.hubs.begin(), labels.hubs.end());
+        s_labels.mutable_weights()->Add(labels.weights.begin(), labels.weights.end());
+        s_labels.mutable_edges()->Add(labels.edges.begin(), labels.edges.end());
+    };
+    proto::HubLabels s_hub_labels;
+    serialize_labels(hub_labels->forward, *s_hub_labels.mutable_forward());
+    serialize_labels(hub_labels->backward, *s_hub_labels.mutable_backward());
+    *s_data.mutable_hub_labels() = std::move(s_hub_labels);
+}
+
+// Ids of removed edges stay empty so the rest keep their positions.
+const std::vector<std::optional<router::EdgeInfo>>
+EdgesInfoToVector(const router::EdgesInfo &edges_info, size_t edge_count) {
+    std::vector<std::optional<router::EdgeInfo>> edge_info_vec(edge_count);
     for (const auto &[id, edge] : edges_info) {
         edge_info_vec[id] = edge;
     }
@@ -224,8 +462,15 @@ const std::vector<router::EdgeInfo> EdgesInfoToVector(const router::EdgesInfo &e
 void Serializer::SerializeRouteInfo(proto::TransportRouter &s_router,
                                     const router::TransportRouter &router) {
 
-    for (const auto &info : EdgesInfoToVector(router.GetEdgesInfo())) {
+    const size_t edge_count = router.GetCsrGraph().GetEdgeCount();
+    for (const auto &edge_info : EdgesInfoToVector(router.GetEdgesInfo(), edge_count)) {
         proto::TransportRouter::EdgeInfo s_info;
+        if (!edge_info) {
+            s_info.set_is_removed_edge(true);
+            *s_router.add_edges_info() = std::move(s_info);
+            continue;
+        }
+        const auto &info = *edge_info;
         if (std::holds_alternative<router::WaitEdgeInfo>(info)) {
             s_info.set_name_id(stop_to_id_.at(std::get<router::WaitEdgeInfo>(info).name));
             s_info.set_time(std::get<router::WaitEdgeInfo>(info).time);
@@ -234,7 +479,17 @@ void Serializer::SerializeRouteInfo(proto::TransportRouter &s_router,
             s_info.set_name_id(bus_to_id_.at(std::get<router::BusEdgeInfo>(info).name));
             s_info.set_time(std::get<router::BusEdgeInfo>(info).time);
             s_info.set_span_count(std::get<router::BusEdgeInfo>(info).span_count);
+            s_info.set_distance(std::get<router::BusEdgeInfo>(info).distance);
             s_info.set_is_bus_edge(true);
+
+        } else if (std::holds_alternative<router::RideEdgeInfo>(info)) {
+            s_info.set_name_id(bus_to_id_.at(std::get<router::RideEdgeInfo>(info).name));
+            s_info.set_distance(std::get<router::RideEdgeInfo>(info).distance);
+            s_info.set_is_ride_edge(true);
+
+        } else if (std::holds_alternative<router::AlightEdgeInfo>(info)) {
+            s_info.set_name_id(stop_to_id_.at(std::get<router::AlightEdgeInfo>(info).name));
+            s_info.set_is_alight_edge(true);
         }
         *s_router.add_edges_info() = std::move(s_info);
     }
@@ -251,6 +506,43 @@ void Serializer::SerializeVertexes(proto::TransportRouter &s_router,
     }
 }
 
+// Removed buses are left out as in SerializeBuses, so the lists stay in bus id order.
+void Serializer::SerializeBusEdges(proto::TransportRouter &s_router,
+                                   const tc::TransportCatalogue &catalogue,
+                                   const router::TransportRouter &router) {
+    const auto &bus_edge_ids = router.GetBusEdgeIds();
+    for (domain::BusId bus = 0; bus < catalogue.GetBusIdCount(); ++bus) {
+        if (catalogue.IsBusRemoved(bus)) {
+            continue;
+        }
+        const auto &edge_ids = bus_edge_ids[bus];
+        s_router.add_bus_edges()->mutable_edge_ids()->Add(edge_ids.begin(), edge_ids.end());
+    }
+}
+
+void Serializer::SerializeRoutingSettings(proto::TransportRouter &s_router,
+                                          const router::RoutingSettings &settings) {
+    using ProtoSettings = proto::TransportRouter::RoutingSettings;
+    ProtoSettings s_settings;
+    s_settings.set_bus_wait_time(settings.bus_wait_time);
+    s_settings.set_bus_velocity(settings.bus_velocity);
+    s_settings.set_mode(static_cast<ProtoSettings::RouterMode>(settings.mode));
+    s_settings.set_graph_model(static_cast<ProtoSettings::GraphModel>(settings.graph_model));
+    s_settings.set_vertex_order(
+        static_cast<ProtoSettings::VertexOrder>(settings.vertex_order));
+    s_settings.set_row_cache_megabytes(settings.row_cache_megabytes);
+    s_settings.set_precompute(static_cast<ProtoSettings::Precompute>(settings.precompute));
+    s_settings.set_precompute_threads(settings.precompute_threads);
+    s_settings.set_landmark_count(settings.landmark_count);
+    for (const auto &profile : settings.profiles) {
+        auto &s_profile = *s_settings.add_profiles();
+        s_profile.set_name(profile.name);
+        s_profile.set_bus_wait_time(profile.bus_wait_time);
+        s_profile.set_bus_velocity(profile.bus_velocity);
+    }
+    *s_router.mutable_settings() = std::move(s_settings);
+}
+
 struct GetSerializedColor {
     [[nodiscard]] proto::Color operator()(std::monostate) const {
         return proto::Color{};
@@ -326,21 +618,31 @@ void Serializer::DeserializeBuses(tc::TransportCatalogue &catalogue) {
         bus.is_roundtrip = s_bus.is_roundtrip();
 
         bus.route.reserve(s_bus.route_size());
-        for (const auto &s_stop : s_bus.route()) {
-            bus.route.push_back(catalogue.SearchStop(db_.catalogue().stops(s_stop).name()));
+        for (const auto s_stop : s_bus.route()) {
+            bus.route.push_back(catalogue.GetStop(s_stop));
         }
-        bus.final_stop =
-            catalogue.SearchStop(db_.catalogue().stops(s_bus.final_stop()).name());
-        catalogue.AddBus(bus);
+        bus.final_stop = catalogue.GetStop(s_bus.final_stop());
+        catalogue.AddBus(std::move(bus));
     }
 }
 
 void Serializer::DeserializeDistances(tc::TransportCatalogue &catalogue) {
-    for (const auto &dist : db_.catalogue().distance()) {
-        catalogue.SetDistanceBetweenStops(db_.catalogue().stops(dist.from_stop_id()).name(),
-                                          db_.catalogue().stops(dist.to_stop_id()).name(),
-                                          dist.dist());
+    const auto &s_distances = db_.catalogue().distances();
+    catalogue.SetDistanceIndex(
+        {{s_distances.offsets().begin(), s_distances.offsets().end()},
+         {s_distances.to_stops().begin(), s_distances.to_stops().end()},
+         {s_distances.dists().begin(), s_distances.dists().end()}});
+}
+
+void Serializer::DeserializeBusStats(tc::TransportCatalogue &catalogue) {
+    std::vector<domain::BusStat> bus_stats;
+    bus_stats.reserve(db_.catalogue().buses_size());
+    for (const auto &s_bus : db_.catalogue().buses()) {
+        const auto &s_stat = s_bus.stat();
+        bus_stats.push_back({s_stat.stops_on_route(), s_stat.unique_stops(),
+                             s_stat.route_length(), s_stat.curvature()});
     }
+    catalogue.SetBusStats(std::move(bus_stats));
 }
 
 svg::Color Serializer::DeserializeColor(const proto::Color &s_color) {
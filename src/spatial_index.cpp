@@ -0,0 +1,155 @@
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace geo {
+
+namespace {
+
+constexpr double EARTH_RADIUS = 6371000;
+constexpr double DEG_TO_RAD = 3.1415926535 / 180.;
+// Keeps the bounds below the distances despite rounding.
+constexpr double BOUND_SLACK = 1.0 - 1e-9;
+
+bool IsLatitudeSplit(size_t depth) {
+    return depth % 2 == 0;
+}
+
+double GetKey(Coordinates point, size_t depth) {
+    return IsLatitudeSplit(depth) ? point.lat : point.lng;
+}
+
+// acos of a value rounded just above 1 gives NaN for coinciding points.
+double GetDistance(Coordinates from, Coordinates to) {
+    const double distance = ComputeDistance(from, to);
+    return std::isnan(distance) ? 0.0 : distance;
+}
+
+// Distance from a point to the great circle through the meridian at longitude
+// difference lng_delta: the lower bound of the way across that meridian.
+double GetMeridianBound(double lat, double lng_delta) {
+    const double sine =
+        std::abs(std::cos(lat * DEG_TO_RAD) * std::sin(lng_delta * DEG_TO_RAD));
+    return std::asin(std::min(1.0, sine)) * EARTH_RADIUS;
+}
+
+} // namespace
+
+SpatialIndex::SpatialIndex(const std::vector<Coordinates> &points)
+    : order_(points.size()), points_(points) {
+    std::iota(order_.begin(), order_.end(), 0);
+    Build(0, order_.size(), 0);
+    for (size_t idx = 0; idx < order_.size(); ++idx) {
+        points_[idx] = points[order_[idx]];
+    }
+    FindLongitudeRange();
+}
+
+SpatialIndex::SpatialIndex(const std::vector<Coordinates> &points, std::vector<uint32_t> order)
+    : order_(std::move(order)) {
+    if (order_.size() != points.size()) {
+        throw std::invalid_argument("Spatial index doesn't match the points");
+    }
+    points_.reserve(order_.size());
+    for (const uint32_t id : order_) {
+        points_.push_back(points.at(id));
+    }
+    FindLongitudeRange();
+}
+
+void SpatialIndex::FindLongitudeRange() {
+    const auto [min_it, max_it] = std::minmax_element(
+        points_.begin(), points_.end(),
+        [](Coordinates lhs, Coordinates rhs) { return lhs.lng < rhs.lng; });
+    if (min_it != points_.end()) {
+        min_lng_ = min_it->lng;
+        max_lng_ = max_it->lng;
+    }
+}
+
+// Lower bound of the distance from center to any point on the other side of the split
+// at `split`. Across a longitude split the other side is a lune between the split and
+// the farthest longitude of the points, bounded by the meridians on both of its edges;
+// the bound is zero when center is in the lune once longitudes wrap.
+double SpatialIndex::GetSplitBound(Coordinates center, double split, size_t depth) const {
+    if (IsLatitudeSplit(depth)) {
+        return std::abs(center.lat - split) * DEG_TO_RAD * EARTH_RADIUS * BOUND_SLACK;
+    }
+    const double begin = center.lng < split ? split : min_lng_;
+    const double end = center.lng < split ? max_lng_ : split;
+    const double offset = std::fmod(center.lng - begin, 360.0);
+    if (begin + (offset < 0.0 ? offset + 360.0 : offset) <= end) {
+        return 0.0;
+    }
+    return std::min(GetMeridianBound(center.lat, begin - center.lng),
+                    GetMeridianBound(center.lat, end - center.lng)) *
+           BOUND_SLACK;
+}
+
+// points_ is in the order of ids while the tree is built.
+void SpatialIndex::Build(size_t begin, size_t end, size_t depth) {
+    if (end - begin < 2) {
+        return;
+    }
+    const size_t mid = (begin + end) / 2;
+    std::nth_element(order_.begin() + begin, order_.begin() + mid, order_.begin() + end,
+                     [this, depth](uint32_t lhs, uint32_t rhs) {
+                         const double lhs_key = GetKey(points_[lhs], depth);
+                         const double rhs_key = GetKey(points_[rhs], depth);
+                         return lhs_key < rhs_key || (lhs_key == rhs_key && lhs < rhs);
+                     });
+    Build(begin, mid, depth + 1);
+    Build(mid + 1, end, depth + 1);
+}
+
+std::vector<SpatialIndex::Neighbour>
+SpatialIndex::FindNearest(Coordinates center, double max_distance, size_t max_count) const {
+    // The farthest of the points found so far on top.
+    std::priority_queue<std::pair<double, uint32_t>> found;
+    const auto get_radius = [&]() {
+        return found.size() < max_count ? max_distance : found.top().first;
+    };
+
+    const auto search = [&](const auto &self, size_t begin, size_t end, size_t depth) {
+        if (begin >= end || max_count == 0) {
+            return;
+        }
+        const size_t mid = (begin + end) / 2;
+        const std::pair<double, uint32_t> candidate{GetDistance(center, points_[mid]),
+                                                    order_[mid]};
+        if (candidate.first <= max_distance) {
+            if (found.size() < max_count) {
+                found.push(candidate);
+            } else if (candidate < found.top()) {
+                found.pop();
+                found.push(candidate);
+            }
+        }
+
+        const double split = GetKey(points_[mid], depth);
+        const bool is_before = GetKey(center, depth) < split;
+        const std::pair<size_t, size_t> near =
+            is_before ? std::pair{begin, mid} : std::pair{mid + 1, end};
+        const std::pair<size_t, size_t> far =
+            is_before ? std::pair{mid + 1, end} : std::pair{begin, mid};
+        self(self, near.first, near.second, depth + 1);
+        if (GetSplitBound(center, split, depth) <= get_radius()) {
+            self(self, far.first, far.second, depth + 1);
+        }
+    };
+    search(search, 0, order_.size(), 0);
+
+    std::vector<Neighbour> neighbours(found.size());
+    for (auto it = neighbours.rbegin(); it != neighbours.rend(); ++it) {
+        *it = {found.top().second, found.top().first};
+        found.pop();
+    }
+    return neighbours;
+}
+
+} // namespace geo
@@ -0,0 +1,93 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace parallel {
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(thread_count - 1);
+    for (size_t idx = 1; idx < thread_count; ++idx) {
+        workers_.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    task_ready_.notify_all();
+    for (auto &worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Run(size_t begin, size_t end, size_t grain, const RangeTask &task) {
+    if (begin >= end) {
+        return;
+    }
+    if (workers_.empty()) {
+        task(begin, end);
+        return;
+    }
+
+    {
+        std::lock_guard lock(mutex_);
+        task_ = &task;
+        next_ = begin;
+        end_ = end;
+        grain_ = std::max<size_t>(grain, 1);
+        busy_workers_ = workers_.size();
+        ++generation_;
+    }
+    task_ready_.notify_all();
+
+    RunChunks();
+
+    std::unique_lock lock(mutex_);
+    task_done_.wait(lock, [this] { return busy_workers_ == 0; });
+    task_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop() {
+    size_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock lock(mutex_);
+            task_ready_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+            if (stop_) {
+                return;
+            }
+            seen_generation = generation_;
+        }
+
+        RunChunks();
+
+        std::lock_guard lock(mutex_);
+        if (--busy_workers_ == 0) {
+            task_done_.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunChunks() {
+    while (true) {
+        size_t chunk_begin;
+        size_t chunk_end;
+        {
+            std::lock_guard lock(mutex_);
+            if (next_ >= end_) {
+                return;
+            }
+            chunk_begin = next_;
+            chunk_end = std::min(end_, next_ + grain_);
+            next_ = chunk_end;
+        }
+        (*task_)(chunk_begin, chunk_end);
+    }
+}
+
+} // namespace parallel
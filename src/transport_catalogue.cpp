@@ -1,6 +1,10 @@
 #include "transport_catalogue.h"
+#include "thread_pool.h"
 
+#include <algorithm>
+#include <iterator>
 #include <numeric>
+#include <stdexcept>
 
 namespace tc {
 
@@ -15,7 +19,13 @@ void TransportCatalogue::AddStop(Stop &&stop) {
 
 void TransportCatalogue::AddStop(StopPtr stop) {
     if (name_to_stop_.count(stop->name) == 0) {
-        name_to_stop_.insert(std::make_pair(std::string_view(stop->name), stop));
+        stop->id = static_cast<StopId>(stops_.size());
+        name_to_stop_.insert(std::make_pair(std::string_view(stop->name), stop->id));
+        stop_names_.push_back(stop->name);
+        stop_coordinates_.push_back(stop->coordinates);
+        stops_.push_back(std::move(stop));
+        is_sorted_stops_current_ = false;
+        is_stop_index_current_ = false;
     }
 }
 void TransportCatalogue::AddBus(Bus &bus) {
@@ -26,91 +36,182 @@ void TransportCatalogue::AddBus(Bus &&bus) {
 }
 
 void TransportCatalogue::AddBus(BusPtr bus) {
-    if (name_to_bus_.count(bus->name) == 0) {
-        name_to_bus_.insert(std::make_pair(std::string_view(bus->name), bus));
-        for (auto stop : bus->route) {
-            if (IsStopInCatalogue(stop)) {
-                stop_to_buses_[std::string_view(stop->name)].insert(bus);
-            }
+    if (name_to_bus_.count(bus->name) > 0) {
+        return;
+    }
+    for (const auto &stop : bus->route) {
+        if (!IsStopInCatalogue(stop)) {
+            throw std::invalid_argument("Bus route has a stop out of the catalogue");
         }
     }
+
+    bus->id = static_cast<BusId>(buses_.size());
+    name_to_bus_.insert(std::make_pair(std::string_view(bus->name), bus->id));
+    for (const auto &stop : bus->route) {
+        stop_to_buses_[std::string_view(stop->name)].insert(bus);
+        route_stops_.push_back(stop->id);
+    }
+    route_offsets_.push_back(route_stops_.size());
+    is_removed_bus_.push_back(false);
+    buses_.push_back(std::move(bus));
+    is_bus_stats_current_ = false;
+    is_sorted_buses_current_ = false;
 }
 
-StopPtr TransportCatalogue::SearchStop(std::string_view name) const {
-    if (name_to_stop_.count(name) > 0) {
-        return name_to_stop_.at(name);
+void TransportCatalogue::RemoveBus(std::string_view name) {
+    const BusPtr bus = SearchBus(name);
+    if (!bus) {
+        return;
     }
-    return nullptr;
+    for (const auto &stop : bus->route) {
+        if (stop_to_buses_.count(stop->name) > 0) {
+            stop_to_buses_.at(stop->name).erase(bus);
+        }
+    }
+    is_removed_bus_[bus->id] = true;
+    name_to_bus_.erase(bus->name);
+    is_sorted_buses_current_ = false;
 }
 
-BusPtr TransportCatalogue::SearchBus(std::string_view name) const {
-    if (name_to_bus_.count(name) > 0) {
-        return name_to_bus_.at(name);
+std::optional<StopId> TransportCatalogue::GetStopId(std::string_view name) const {
+    const auto it = name_to_stop_.find(name);
+    if (it == name_to_stop_.end()) {
+        return std::nullopt;
     }
-    return nullptr;
+    return it->second;
+}
+
+std::optional<BusId> TransportCatalogue::GetBusId(std::string_view name) const {
+    const auto it = name_to_bus_.find(name);
+    if (it == name_to_bus_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
 }
 
-void TransportCatalogue::SetDistanceBetweenStops(StopPtr from,
-                                                 StopPtr to,
+StopPtr TransportCatalogue::SearchStop(std::string_view name) const {
+    const auto id = GetStopId(name);
+    return id ? stops_[*id] : nullptr;
+}
+
+BusPtr TransportCatalogue::SearchBus(std::string_view name) const {
+    const auto id = GetBusId(name);
+    return id ? buses_[*id] : nullptr;
+}
+
+void TransportCatalogue::SetDistanceBetweenStops(const StopPtr &from,
+                                                 const StopPtr &to,
                                                  const double distance) {
     if (IsStopInCatalogue(from) && IsStopInCatalogue(to)) {
-        stops_to_distance_[{from, to}] = distance;
+        pending_distances_[{from->id, to->id}] = distance;
+        is_bus_stats_current_ = false;
     }
 }
 
 void TransportCatalogue::SetDistanceBetweenStops(const std::string_view &from,
                                                  const std::string_view &to,
                                                  const double distance) {
-    StopPtr stop_from = SearchStop(from);
-    StopPtr stop_to = SearchStop(to);
+    const auto stop_from = GetStopId(from);
+    const auto stop_to = GetStopId(to);
     if (stop_from && stop_to) {
-        stops_to_distance_[{stop_from, stop_to}] = distance;
+        pending_distances_[{*stop_from, *stop_to}] = distance;
+        is_bus_stats_current_ = false;
     }
 }
 
-double TransportCatalogue::GetDistanceBetweenStops(StopPtr from, StopPtr to) const {
-    if (stops_to_distance_.count({from, to}) > 0) {
-        return stops_to_distance_.at({from, to});
+double TransportCatalogue::GetDistanceBetweenStops(const StopPtr &from,
+                                                   const StopPtr &to) const {
+    return GetDistanceBetweenStops(from->id, to->id);
+}
+
+// A pair set only the other way round gives its distance.
+double TransportCatalogue::GetDistanceBetweenStops(StopId from, StopId to) const {
+    const auto find = [this](StopId from, StopId to) -> std::optional<double> {
+        if (!pending_distances_.empty()) {
+            if (const auto it = pending_distances_.find({from, to});
+                it != pending_distances_.end()) {
+                return it->second;
+            }
+        }
+        return distance_index_.Find(from, to);
+    };
+    if (const auto distance = find(from, to)) {
+        return *distance;
     }
-    if (stops_to_distance_.count({to, from}) > 0) {
-        return stops_to_distance_.at({to, from});
+    return find(to, from).value_or(0.0);
+}
+
+const DistanceIndex &TransportCatalogue::GetDistanceIndex() const {
+    if (!pending_distances_.empty()) {
+        distance_index_ = DistanceIndex(distance_index_, pending_distances_, stops_.size());
+        pending_distances_.clear();
     }
+    return distance_index_;
+}
 
-    return 0.0;
+void TransportCatalogue::FreezeDistances() {
+    GetDistanceIndex();
 }
 
-const StopsDist* TransportCatalogue::GetDistances() const
-{
-    return &stops_to_distance_;
+void TransportCatalogue::SetDistanceIndex(DistanceIndex::Data data) {
+    if (data.offsets.size() > stops_.size() + 1) {
+        throw std::invalid_argument("Distance rows don't match the stops");
+    }
+    distance_index_ = DistanceIndex(std::move(data));
+    pending_distances_.clear();
+    is_bus_stats_current_ = false;
 }
 
 const std::optional<BusStat>
 TransportCatalogue::GetBusStat(const std::string_view &bus_name) const {
-    auto bus = SearchBus(bus_name);
-    if (bus == nullptr) {
+    const auto bus = GetBusId(bus_name);
+    if (!bus) {
         return {};
     }
+    return GetBusStat(*bus);
+}
 
-    std::unordered_set<std::string_view> unique_stops;
+BusStat TransportCatalogue::GetBusStat(BusId bus) const {
+    return is_bus_stats_current_ ? bus_stats_[bus] : ComputeBusStat(bus);
+}
 
-    std::pair<double, double> length = std::transform_reduce(
-        ++bus->route.begin(), bus->route.end(), bus->route.begin(),
-        std::pair<double, double>{0.0, 0.0},
-        [](const auto lhs, const auto rhs) {
-            return std::pair<double, double>{lhs.first + rhs.first, lhs.second + rhs.second};
-        },
-        [&](const auto lhs, const auto rhs) {
-            unique_stops.insert(lhs->name);
-            return std::pair<double, double>{
-                GetDistanceBetweenStops(rhs, lhs),
-                ComputeDistance(lhs->coordinates, rhs->coordinates)};
-        });
+void TransportCatalogue::ComputeBusStats(size_t thread_count) {
+    std::vector<BusStat> bus_stats(buses_.size());
+    parallel::ThreadPool pool(thread_count);
+    pool.ParallelFor(0, bus_stats.size(), [&](size_t bus) {
+        bus_stats[bus] = ComputeBusStat(static_cast<BusId>(bus));
+    });
+    bus_stats_ = std::move(bus_stats);
+    is_bus_stats_current_ = true;
+}
+
+void TransportCatalogue::SetBusStats(std::vector<BusStat> bus_stats) {
+    if (bus_stats.size() != buses_.size()) {
+        throw std::invalid_argument("Bus statistics don't match the buses");
+    }
+    bus_stats_ = std::move(bus_stats);
+    is_bus_stats_current_ = true;
+}
+
+// Walks the stop ids of the route; unique stops are counted on a sorted copy of them.
+BusStat TransportCatalogue::ComputeBusStat(BusId bus) const {
+    const RouteStops route = GetRouteStops(bus);
+    double road_length = 0.0;
+    double geo_length = 0.0;
+    for (auto it = route.begin(); it != route.end() && std::next(it) != route.end(); ++it) {
+        const StopId next = *std::next(it);
+        road_length += GetDistanceBetweenStops(*it, next);
+        geo_length += ComputeDistance(stop_coordinates_[*it], stop_coordinates_[next]);
+    }
+    std::vector<StopId> unique_stops(route.begin(), route.end());
+    std::sort(unique_stops.begin(), unique_stops.end());
 
     domain::BusStat info;
-    info.stops_on_route = bus->route.size();
-    info.unique_stops = unique_stops.size();
-    info.route_length = length.first;
-    info.curvature = length.first / length.second;
+    info.stops_on_route = unique_stops.size();
+    info.unique_stops =
+        std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
+    info.route_length = road_length;
+    info.curvature = road_length / geo_length;
     return info;
 }
 
@@ -122,23 +223,75 @@ TransportCatalogue::GetBusesByStop(const std::string_view &stop_name) const {
     return nullptr;
 }
 
-bool TransportCatalogue::IsStopInCatalogue(StopPtr stop) const {
-    return name_to_stop_.count(stop->name) && name_to_stop_.at(stop->name).get() == stop.get();
+bool TransportCatalogue::IsStopInCatalogue(const StopPtr &stop) const {
+    return stop && stop->id < stops_.size() && stops_[stop->id].get() == stop.get();
 }
 
-const domain::BusPtrSet TransportCatalogue::GetBuses() const {
-    domain::BusPtrSet buses;
-    for (const auto &[_, bus] : name_to_bus_) {
-        buses.insert(bus);
+// Names compare as in domain::StopPtrComparator and BusPtrComparator.
+StopIdRange TransportCatalogue::GetSortedStops() const {
+    if (!is_sorted_stops_current_) {
+        sorted_stops_.resize(stops_.size());
+        std::iota(sorted_stops_.begin(), sorted_stops_.end(), StopId{0});
+        std::sort(sorted_stops_.begin(), sorted_stops_.end(), [this](StopId lhs, StopId rhs) {
+            return std::lexicographical_compare(stop_names_[lhs].begin(),
+                                                stop_names_[lhs].end(),
+                                                stop_names_[rhs].begin(),
+                                                stop_names_[rhs].end());
+        });
+        is_sorted_stops_current_ = true;
+    }
+    return ranges::AsRange(sorted_stops_);
+}
+
+BusIdRange TransportCatalogue::GetSortedBuses() const {
+    if (!is_sorted_buses_current_) {
+        sorted_buses_.clear();
+        for (BusId bus = 0; bus < buses_.size(); ++bus) {
+            if (!is_removed_bus_[bus]) {
+                sorted_buses_.push_back(bus);
+            }
+        }
+        std::sort(sorted_buses_.begin(), sorted_buses_.end(), [this](BusId lhs, BusId rhs) {
+            const std::string &lhs_name = buses_[lhs]->name;
+            const std::string &rhs_name = buses_[rhs]->name;
+            return std::lexicographical_compare(lhs_name.begin(), lhs_name.end(),
+                                                rhs_name.begin(), rhs_name.end());
+        });
+        is_sorted_buses_current_ = true;
+    }
+    return ranges::AsRange(sorted_buses_);
+}
+
+std::vector<BusPtr> TransportCatalogue::GetBuses() const {
+    std::vector<BusPtr> buses;
+    buses.reserve(name_to_bus_.size());
+    for (const BusId bus : GetSortedBuses()) {
+        buses.push_back(buses_[bus]);
     }
     return buses;
 }
 
-const domain::StopPtrSet TransportCatalogue::GetStops() const
-{
-    domain::StopPtrSet stops;
-    for (const auto &[_, stop] : name_to_stop_) {
-        stops.insert(stop);
+const geo::SpatialIndex &TransportCatalogue::GetStopIndex() const {
+    if (!is_stop_index_current_) {
+        stop_index_ = geo::SpatialIndex(stop_coordinates_);
+        is_stop_index_current_ = true;
+    }
+    return stop_index_;
+}
+
+void TransportCatalogue::SetStopIndex(std::vector<StopId> order) {
+    stop_index_ = geo::SpatialIndex(stop_coordinates_, std::move(order));
+    is_stop_index_current_ = true;
+}
+
+NearbyStops TransportCatalogue::GetNearbyStops(geo::Coordinates center,
+                                               double max_distance,
+                                               size_t max_count) const {
+    const auto neighbours = GetStopIndex().FindNearest(center, max_distance, max_count);
+    NearbyStops stops;
+    stops.reserve(neighbours.size());
+    for (const auto &[stop, distance] : neighbours) {
+        stops.push_back({stop_names_[stop], distance});
     }
     return stops;
 }
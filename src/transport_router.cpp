@@ -1,56 +1,583 @@
 #include "transport_router.h"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_set>
+#include <utility>
+
 namespace router {
 
 TransportRouter::TransportRouter(const tc::TransportCatalogue &catalogue,
                                  const RoutingSettings &settings)
     : catalogue_(catalogue), settings_(settings) {
 
-    InitializeVertexes();
-    InitializeEdges();
+    bus_edge_ids_.resize(catalogue_.GetBusIdCount());
+    if (settings_.graph_model == GraphModel::ROUTE_STOPS) {
+        InitializeRouteStopGraph();
+    } else {
+        InitializeVertexes();
+        InitializeEdges();
+    }
+    if (settings_.vertex_order == VertexOrder::CUTHILL_MCKEE) {
+        RenumberVertexes();
+    }
+    FreezeGraph();
+
+    const auto start = std::chrono::steady_clock::now();
+    InitializeRouter();
+    InitializeComponents();
+    InitializeProfiles();
+    precompute_stats_.time = std::chrono::steady_clock::now() - start;
 
-    router_ = std::make_unique<Router>(graph_);
+    if (settings_.verify_precompute && settings_.mode == RouterMode::ALL_PAIRS) {
+        VerifyPrecompute();
+    }
 }
 
 TransportRouter::TransportRouter(const tc::TransportCatalogue &catalogue,
+                                 const RoutingSettings &settings,
                                  const StopVertexes &vertex_ids,
                                  const EdgesInfo &edges_info,
-                                 const Graph &graph,
-                                 const Router::RoutesInternalData &internal_data)
-    : catalogue_(catalogue), stops_vertex_ids_(vertex_ids), edges_info_(edges_info),
-      graph_(graph) {
+                                 const BusEdgeIds &bus_edge_ids,
+                                 const CsrGraph &graph,
+                                 graph::ComponentIndex::Data &&components,
+                                 RouterData &&router_data,
+                                 ProfilesData &&profiles_data)
+    : catalogue_(catalogue), settings_(settings), stops_vertex_ids_(vertex_ids),
+      edges_info_(edges_info), bus_edge_ids_(bus_edge_ids),
+      graph_(NeedsGraph(settings.mode) ? graph.ToGraph() : Graph()), csr_graph_(graph) {
+
+    if (bus_edge_ids_.size() != catalogue_.GetBusIdCount()) {
+        throw std::invalid_argument("Bus edges don't match the catalogue");
+    }
+    InitializeRouter(std::move(router_data));
+    InitializeComponents(std::move(components));
+    InitializeProfiles(std::move(profiles_data));
+}
+
+const Router::RoutesInternalData *
+TransportRouter::GetRoutesInternalData(std::string_view profile) const {
+    if (const auto *table = dynamic_cast<const Router *>(FindRouter(profile))) {
+        return &table->GetRoutesInternalData();
+    }
+    return nullptr;
+}
+
+const ContractionHierarchy::Data *
+TransportRouter::GetContractionHierarchy(std::string_view profile) const {
+    const auto *router = FindRouter(profile);
+    if (const auto *hierarchy = dynamic_cast<const ContractionHierarchy *>(router)) {
+        return &hierarchy->GetData();
+    }
+    if (const auto *hub_labels = dynamic_cast<const HubLabels *>(router)) {
+        return &hub_labels->GetHierarchy().GetData();
+    }
+    return nullptr;
+}
+
+const LandmarkRouter::Data *TransportRouter::GetLandmarks(std::string_view profile) const {
+    if (const auto *landmarks = dynamic_cast<const LandmarkRouter *>(FindRouter(profile))) {
+        return &landmarks->GetData();
+    }
+    return nullptr;
+}
+
+const HubLabels::Data *TransportRouter::GetHubLabels(std::string_view profile) const {
+    if (const auto *hub_labels = dynamic_cast<const HubLabels *>(FindRouter(profile))) {
+        return &hub_labels->GetData();
+    }
+    return nullptr;
+}
 
-    router_ = std::make_unique<Router>(graph_, internal_data);
+const graph::IRouter<Time> *TransportRouter::FindRouter(std::string_view profile) const {
+    if (profile.empty()) {
+        return router_.get();
+    }
+    const auto it = profiles_.find(profile);
+    return it != profiles_.end() ? it->second->router.get() : nullptr;
+}
+
+const RoutingSettings *TransportRouter::FindSettings(std::string_view profile) const {
+    if (profile.empty()) {
+        return &settings_;
+    }
+    const auto it = profiles_.find(profile);
+    return it != profiles_.end() ? &it->second->settings : nullptr;
 }
 
 std::optional<RouteInfo> TransportRouter::GetRouteInfo(std::string_view from,
-                                                       std::string_view to) const {
-    auto route =
-        router_->BuildRoute(stops_vertex_ids_.at(from).in, stops_vertex_ids_.at(to).in);
+                                                       std::string_view to,
+                                                       std::string_view profile) const {
+    const RoutingSettings *profile_settings = FindSettings(profile);
+    if (!profile_settings) {
+        return {};
+    }
+    const graph::VertexId from_vertex = stops_vertex_ids_.at(from).in;
+    const graph::VertexId to_vertex = stops_vertex_ids_.at(to).in;
+    if (!components_.MayReach(from_vertex, to_vertex)) {
+        return {};
+    }
+    if (raptor_) {
+        return GetRaptorRouteInfo(from, to, *profile_settings);
+    }
+    const auto *router = FindRouter(profile);
+    auto route = router->BuildRoute(from_vertex, to_vertex);
     if (!route) {
         return {};
     }
+    const RoutingSettings &settings = *profile_settings;
     RouteInfo route_info;
     route_info.first = route->weight;
     auto &route_items = route_info.second;
 
     route_items.reserve(route->edges.size());
+
+    // Consecutive ride edges of the route-stop model are one Bus item, its time is
+    // computed from the summed distance exactly as for a stop-pairs edge. Item times
+    // come from the settings of the profile, not from edges_info_.
+    std::optional<BusEdgeInfo> ride;
+    double ride_distance{};
+    const auto finish_ride = [&] {
+        if (ride) {
+            ride->time = GetRideTime(ride_distance, settings.bus_velocity);
+            route_items.push_back(*ride);
+            ride.reset();
+            ride_distance = 0;
+        }
+    };
+
     for (const auto &edge_id : route->edges) {
-        route_items.push_back(edges_info_.at(edge_id));
+        const auto &edge_info = edges_info_.at(edge_id);
+        if (const auto *ride_edge = std::get_if<RideEdgeInfo>(&edge_info)) {
+            if (!ride) {
+                ride = BusEdgeInfo{ride_edge->name, 0, 0, 0};
+            }
+            ++ride->span_count;
+            ride_distance += ride_edge->distance;
+            continue;
+        }
+        finish_ride();
+        if (const auto *wait_edge = std::get_if<WaitEdgeInfo>(&edge_info)) {
+            route_items.push_back(
+                WaitEdgeInfo{wait_edge->name, GetEdgeWeight(edge_info, settings)});
+        } else if (const auto *bus_edge = std::get_if<BusEdgeInfo>(&edge_info)) {
+            BusEdgeInfo bus_item = *bus_edge;
+            bus_item.time = GetEdgeWeight(edge_info, settings);
+            route_items.push_back(bus_item);
+        }
     }
+    finish_ride();
+
+    return route_info;
+}
 
+TravelTimes TransportRouter::GetTravelTimes(const std::vector<std::string_view> &from,
+                                           const std::vector<std::string_view> &to,
+                                           std::string_view profile) const {
+    const RoutingSettings *settings = FindSettings(profile);
+    if (settings && raptor_) {
+        return GetRaptorTravelTimes(from, to, *settings);
+    }
+
+    std::vector<graph::VertexId> targets;
+    std::vector<size_t> target_columns;
+    for (size_t column = 0; column < to.size(); ++column) {
+        const auto it = stops_vertex_ids_.find(to[column]);
+        if (it != stops_vertex_ids_.end()) {
+            targets.push_back(it->second.in);
+            target_columns.push_back(column);
+        }
+    }
+
+    TravelTimes travel_times(from.size(), std::vector<std::optional<Time>>(to.size()));
+    const auto *router = FindRouter(profile);
+    if (!settings || !router) {
+        return travel_times;
+    }
+    for (size_t row = 0; row < from.size(); ++row) {
+        const auto it = stops_vertex_ids_.find(from[row]);
+        if (it == stops_vertex_ids_.end()) {
+            continue;
+        }
+        const auto weights = router->BuildWeights(it->second.in, targets);
+        for (size_t idx = 0; idx < targets.size(); ++idx) {
+            travel_times[row][target_columns[idx]] = weights[idx];
+        }
+    }
+    return travel_times;
+}
+
+// Every leg of a journey is a Wait and a Bus item, the ride time is computed from the
+// leg distance exactly as for a graph edge.
+std::optional<RouteInfo> TransportRouter::GetRaptorRouteInfo(
+    std::string_view from, std::string_view to, const RoutingSettings &settings) const {
+    const RaptorRouter::Costs costs{static_cast<double>(settings.bus_wait_time),
+                                    settings.bus_velocity};
+    const auto journey =
+        raptor_->BuildRoute(catalogue_.SearchStop(from), catalogue_.SearchStop(to), costs);
+    if (!journey) {
+        return {};
+    }
+
+    RouteInfo route_info;
+    route_info.first = journey->time;
+    route_info.second.reserve(journey->legs.size() * 2);
+    for (const auto &leg : journey->legs) {
+        route_info.second.push_back(
+            WaitEdgeInfo{leg.bus->route[leg.board]->name, costs.wait_time});
+        route_info.second.push_back(BusEdgeInfo{leg.bus->name,
+                                                static_cast<int>(leg.alight - leg.board),
+                                                GetRideTime(leg.distance, costs.bus_velocity),
+                                                leg.distance});
+    }
     return route_info;
 }
 
+TravelTimes TransportRouter::GetRaptorTravelTimes(const std::vector<std::string_view> &from,
+                                                 const std::vector<std::string_view> &to,
+                                                 const RoutingSettings &settings) const {
+    const RaptorRouter::Costs costs{static_cast<double>(settings.bus_wait_time),
+                                    settings.bus_velocity};
+    std::vector<domain::StopPtr> targets;
+    targets.reserve(to.size());
+    for (const auto &stop_name : to) {
+        targets.push_back(catalogue_.SearchStop(stop_name));
+    }
+
+    TravelTimes travel_times;
+    travel_times.reserve(from.size());
+    for (const auto &stop_name : from) {
+        travel_times.push_back(
+            raptor_->BuildWeights(catalogue_.SearchStop(stop_name), targets, costs));
+    }
+    return travel_times;
+}
+
+std::optional<ReachableStops>
+TransportRouter::GetReachableStops(std::string_view from,
+                                   Time max_time,
+                                   std::string_view profile) const {
+    const RoutingSettings *settings = FindSettings(profile);
+    const auto from_stop = catalogue_.SearchStop(from);
+    if (!settings || !from_stop) {
+        return std::nullopt;
+    }
+
+    ReachableStops reachable_stops;
+    if (raptor_) {
+        const RaptorRouter::Costs costs{static_cast<double>(settings->bus_wait_time),
+                                        settings->bus_velocity};
+        for (const auto &[stop, time] : raptor_->BuildReachable(from_stop, max_time, costs)) {
+            reachable_stops.emplace_back(stop->name, time);
+        }
+    } else {
+        const DijkstraRouter &search = profile.empty()
+                                           ? *bounded_search_
+                                           : *profiles_.find(profile)->second->bounded_search;
+        const auto reachable = search.BuildReachable(stops_vertex_ids_.at(from).in, max_time);
+        for (const auto &[vertex, time] : reachable) {
+            if (!vertex_stops_[vertex].empty()) {
+                reachable_stops.emplace_back(vertex_stops_[vertex], time);
+            }
+        }
+    }
+    std::sort(reachable_stops.begin(), reachable_stops.end(),
+              [](const auto &lhs, const auto &rhs) {
+                  return std::tie(lhs.second, lhs.first) < std::tie(rhs.second, rhs.first);
+              });
+    return reachable_stops;
+}
+
+void TransportRouter::InitializeRouter(RouterData &&router_data) {
+    InitializeSearch();
+    router_ = MakeRouter(settings_, graph_, csr_graph_, std::move(router_data));
+    raptor_ = settings_.mode == RouterMode::RAPTOR
+                  ? std::make_unique<RaptorRouter>(catalogue_, &GetRideTime)
+                  : nullptr;
+}
+
+// Called whenever the topology of graph_ has changed. Profiles share the arrays of
+// csr_graph_, so a change of weights only goes through CsrGraph::WithWeights instead.
+void TransportRouter::FreezeGraph() {
+    csr_graph_ = CsrGraph(graph_);
+    if (!NeedsGraph(settings_.mode)) {
+        graph_ = Graph();
+    }
+}
+
+// Restores a released graph_ from csr_graph_ before an edit, with the same edge ids.
+void TransportRouter::ThawGraph() {
+    if (graph_.GetVertexCount() == 0) {
+        graph_ = csr_graph_.ToGraph();
+    }
+}
+
+// Everything that follows the topology of csr_graph_ whatever the router is.
+void TransportRouter::InitializeSearch() {
+    bounded_search_ = std::make_unique<DijkstraRouter>(csr_graph_);
+    vertex_stops_.assign(csr_graph_.GetVertexCount(), {});
+    for (const auto &[name, vertex_ids] : stops_vertex_ids_) {
+        vertex_stops_[vertex_ids.in] = name;
+    }
+}
+
+// Stored components are taken as they are when they cover the graph, a base written
+// without them gets them computed.
+void TransportRouter::InitializeComponents(graph::ComponentIndex::Data &&data) {
+    if (data.strong.size() == csr_graph_.GetVertexCount()) {
+        components_ = graph::ComponentIndex(std::move(data));
+    } else {
+        components_ = graph::ComponentIndex(csr_graph_);
+    }
+}
+
+void TransportRouter::InitializeProfiles(ProfilesData &&profiles_data) {
+    profiles_.clear();
+    for (size_t idx = 0; idx < settings_.profiles.size(); ++idx) {
+        const RoutingProfile &routing_profile = settings_.profiles[idx];
+        auto profile = std::make_unique<Profile>();
+        profile->settings = MakeProfileSettings(routing_profile);
+        if (settings_.mode != RouterMode::RAPTOR) {
+            ReweightProfile(*profile);
+            BuildProfileRouter(*profile, idx < profiles_data.size()
+                                             ? std::move(profiles_data[idx])
+                                             : RouterData{});
+        }
+        profiles_[routing_profile.name] = std::move(profile);
+    }
+}
+
+// Profiles follow the base router: an edge changes the same way under every profile, as
+// ride times grow with the distance, so all-pairs tables are repaired in place. The
+// other engines are customized while the vertices stay, or rebuilt from the base
+// preprocessing.
+void TransportRouter::UpdateProfiles(const std::vector<graph::EdgeId> &decreased,
+                                     const std::vector<graph::EdgeId> &increased,
+                                     bool is_same_vertexes) {
+    if (settings_.mode == RouterMode::RAPTOR) {
+        return;
+    }
+    for (auto &[name, profile] : profiles_) {
+        ReweightProfile(*profile);
+        if (auto *table = dynamic_cast<Router *>(profile->router.get())) {
+            table->Update(decreased, increased);
+        } else if (is_same_vertexes && IsCustomizable(settings_.mode)) {
+            Customize(*profile->router);
+        } else {
+            BuildProfileRouter(*profile, {});
+        }
+    }
+}
+
+// A profile whose costs and engine settings are the same keeps its preprocessing, the
+// others are customized when the base router could be, or rebuilt.
+void TransportRouter::ReconfigureProfiles(bool is_customizable) {
+    auto old_profiles = std::move(profiles_);
+    profiles_.clear();
+    for (const RoutingProfile &routing_profile : settings_.profiles) {
+        const auto it = old_profiles.find(routing_profile.name);
+        auto profile = it != old_profiles.end() ? std::move(it->second)
+                                                : std::make_unique<Profile>();
+        const RoutingSettings old_settings =
+            std::exchange(profile->settings, MakeProfileSettings(routing_profile));
+        const RoutingSettings &settings = profile->settings;
+        const bool is_same = profile->router && settings.mode == old_settings.mode &&
+                             settings.bus_wait_time == old_settings.bus_wait_time &&
+                             settings.bus_velocity == old_settings.bus_velocity &&
+                             settings.landmark_count == old_settings.landmark_count &&
+                             settings.row_cache_megabytes == old_settings.row_cache_megabytes;
+        if (settings_.mode != RouterMode::RAPTOR && !is_same) {
+            ReweightProfile(*profile);
+            if (is_customizable && profile->router) {
+                Customize(*profile->router);
+            } else {
+                BuildProfileRouter(*profile, {});
+            }
+        }
+        profiles_[routing_profile.name] = std::move(profile);
+    }
+}
+
+RoutingSettings
+TransportRouter::MakeProfileSettings(const RoutingProfile &routing_profile) const {
+    RoutingSettings settings = settings_;
+    settings.bus_wait_time = routing_profile.bus_wait_time;
+    settings.bus_velocity = routing_profile.bus_velocity;
+    settings.profiles.clear();
+    return settings;
+}
+
+// Weighs the current arcs of csr_graph_, and the edges of graph_ for the engines that
+// need a Graph, with the costs of the profile.
+void TransportRouter::ReweightProfile(Profile &profile) const {
+    std::vector<Time> weights = GetArcWeights(profile.settings);
+    if (NeedsGraph(profile.settings.mode)) {
+        profile.graph = graph_;
+        for (size_t arc = 0; arc < weights.size(); ++arc) {
+            profile.graph.SetEdgeWeight(csr_graph_.GetEdgeId(arc), weights[arc]);
+        }
+    } else {
+        profile.graph = Graph();
+    }
+    profile.csr_graph = csr_graph_.WithWeights(std::move(weights));
+    profile.bounded_search = std::make_unique<DijkstraRouter>(profile.csr_graph);
+}
+
+// Without stored data a profile reuses what of the base preprocessing does not depend
+// on the weights: the contraction order of a hierarchy or the landmark vertices.
+void TransportRouter::BuildProfileRouter(Profile &profile, RouterData &&router_data) const {
+    bool customize = false;
+    if (std::holds_alternative<std::monostate>(router_data)) {
+        if (const auto *hierarchy = GetContractionHierarchy()) {
+            router_data = ContractionHierarchy::Data{hierarchy->ranks, {}};
+            customize = true;
+        } else if (const auto *landmarks = GetLandmarks()) {
+            router_data = LandmarkRouter::Data{landmarks->landmarks, {}, {}};
+            customize = true;
+        }
+    }
+    profile.router = MakeRouter(profile.settings, profile.graph, profile.csr_graph,
+                                std::move(router_data));
+    if (customize) {
+        Customize(*profile.router);
+    }
+}
+
+RouterPtr TransportRouter::MakeRouter(const RoutingSettings &settings,
+                                      const Graph &graph,
+                                      const CsrGraph &csr_graph,
+                                      RouterData &&router_data) const {
+    switch (settings.mode) {
+    case RouterMode::ALL_PAIRS:
+        if (auto *internal_data = std::get_if<Router::RoutesInternalData>(&router_data)) {
+            return std::make_unique<Router>(graph, std::move(*internal_data));
+        }
+        return std::make_unique<Router>(graph, settings.precompute,
+                                        settings.precompute_threads);
+    case RouterMode::DIJKSTRA:
+        return std::make_unique<DijkstraRouter>(csr_graph);
+    case RouterMode::A_STAR:
+        return std::make_unique<DijkstraRouter>(csr_graph, MakeGeoPotential(csr_graph));
+    case RouterMode::LANDMARKS:
+        if (auto *landmarks = std::get_if<LandmarkRouter::Data>(&router_data)) {
+            return std::make_unique<LandmarkRouter>(csr_graph, std::move(*landmarks));
+        }
+        return std::make_unique<LandmarkRouter>(csr_graph, settings.landmark_count);
+    case RouterMode::CONTRACTION_HIERARCHIES:
+        if (auto *hierarchy = std::get_if<ContractionHierarchy::Data>(&router_data)) {
+            return std::make_unique<ContractionHierarchy>(graph, std::move(*hierarchy));
+        }
+        return std::make_unique<ContractionHierarchy>(graph);
+    case RouterMode::HUB_LABELS:
+        if (auto *hub_labels = std::get_if<HubLabelsData>(&router_data)) {
+            return std::make_unique<HubLabels>(graph, std::move(hub_labels->hierarchy),
+                                               std::move(hub_labels->labels));
+        }
+        if (auto *hierarchy = std::get_if<ContractionHierarchy::Data>(&router_data)) {
+            return std::make_unique<HubLabels>(graph, std::move(*hierarchy));
+        }
+        return std::make_unique<HubLabels>(graph);
+    case RouterMode::LAZY_ROWS:
+        return std::make_unique<RowCacheRouter>(csr_graph, settings.row_cache_megabytes << 20);
+    case RouterMode::RAPTOR:
+        // Lines are scanned by raptor_, built from the catalogue.
+        return {};
+    }
+    return {};
+}
+
+void TransportRouter::Customize(graph::IRouter<Time> &router) {
+    if (auto *hierarchy = dynamic_cast<ContractionHierarchy *>(&router)) {
+        hierarchy->Customize();
+    } else if (auto *landmarks = dynamic_cast<LandmarkRouter *>(&router)) {
+        landmarks->Customize();
+    } else if (auto *hub_labels = dynamic_cast<HubLabels *>(&router)) {
+        hub_labels->Customize();
+    }
+}
+
+// Every bus edge costs at least min_minutes_per_meter per metre of its great-circle
+// length: the scale is the smallest ratio over single-span edges, and a longer edge sums
+// the spans after the last visit of its first stop. Triangle inequality then makes the
+// potential consistent even when road distances are shorter than straight lines.
+DijkstraRouter::Potential TransportRouter::MakeGeoPotential(const CsrGraph &graph) const {
+    std::vector<geo::Coordinates> coordinates(graph.GetVertexCount());
+    for (const auto &[name, vertex_ids] : stops_vertex_ids_) {
+        const auto stop = catalogue_.SearchStop(name);
+        coordinates[vertex_ids.in] = stop->coordinates;
+        coordinates[vertex_ids.out] = stop->coordinates;
+    }
+    // Every route-stop vertex but the last one of a route is boarded, every one but the
+    // first is alighted from, so the two edge kinds together place all of them.
+    for (graph::VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+        for (size_t arc = graph.GetArcsBegin(vertex); arc < graph.GetArcsEnd(vertex); ++arc) {
+            const auto &edge_info = edges_info_.at(graph.GetEdgeId(arc));
+            if (std::holds_alternative<WaitEdgeInfo>(edge_info)) {
+                coordinates[graph.GetTarget(arc)] = coordinates[vertex];
+            } else if (std::holds_alternative<AlightEdgeInfo>(edge_info)) {
+                coordinates[vertex] = coordinates[graph.GetTarget(arc)];
+            }
+        }
+    }
+
+    Time min_minutes_per_meter = std::numeric_limits<Time>::max();
+    for (graph::VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+        for (size_t arc = graph.GetArcsBegin(vertex); arc < graph.GetArcsEnd(vertex); ++arc) {
+            const auto &edge_info = edges_info_.at(graph.GetEdgeId(arc));
+            const auto *bus_edge = std::get_if<BusEdgeInfo>(&edge_info);
+            if (!std::holds_alternative<RideEdgeInfo>(edge_info) &&
+                (!bus_edge || bus_edge->span_count != 1)) {
+                continue;
+            }
+            const double distance = geo::ComputeDistance(coordinates[vertex],
+                                                         coordinates[graph.GetTarget(arc)]);
+            if (distance > 0) {
+                min_minutes_per_meter =
+                    std::min(min_minutes_per_meter, graph.GetWeight(arc) / distance);
+            }
+        }
+    }
+    if (min_minutes_per_meter == std::numeric_limits<Time>::max()) {
+        min_minutes_per_meter = 0;
+    }
+    min_minutes_per_meter *= POTENTIAL_SLACK;
+
+    return [coordinates = std::move(coordinates), min_minutes_per_meter](
+               graph::VertexId vertex, graph::VertexId to) {
+        const double distance = geo::ComputeDistance(coordinates[vertex], coordinates[to]);
+        return distance > 0 ? distance * min_minutes_per_meter : Time{};
+    };
+}
+
+bool IsBitIdentical(const Router::RoutesInternalData &lhs,
+                    const Router::RoutesInternalData &rhs) {
+    return lhs.vertex_count == rhs.vertex_count && lhs.prev_edges == rhs.prev_edges &&
+           lhs.weights.size() == rhs.weights.size() &&
+           std::memcmp(lhs.weights.data(), rhs.weights.data(),
+                       lhs.weights.size() * sizeof(Time)) == 0;
+}
+
+void TransportRouter::VerifyPrecompute() {
+    const auto start = std::chrono::steady_clock::now();
+    const Router sequential(graph_, graph::RoutesPrecompute::SEQUENTIAL);
+    precompute_stats_.sequential_time = std::chrono::steady_clock::now() - start;
+    precompute_stats_.identical =
+        IsBitIdentical(sequential.GetRoutesInternalData(), *GetRoutesInternalData());
+}
+
 void TransportRouter::InitializeVertexes() {
     size_t vertex_id{};
     Time weight = settings_.bus_wait_time;
-    domain::StopPtrSet stops = catalogue_.GetStops();
+    const size_t stop_count = catalogue_.GetStopsCount();
 
-    graph_ = Graph(stops.size() * 2);
-    edges_info_.reserve(stops.size() * 2);
+    graph_ = Graph(stop_count * 2);
+    edges_info_.reserve(stop_count * 2);
 
-    for (const auto &stop : stops) {
+    for (const domain::StopId stop_id : catalogue_.GetSortedStops()) {
+        const auto &stop = catalogue_.GetStop(stop_id);
         auto &vertex_ids = stops_vertex_ids_[stop->name];
         vertex_ids.in = vertex_id++;
         vertex_ids.out = vertex_id++;
@@ -60,36 +587,368 @@ void TransportRouter::InitializeVertexes() {
     }
 }
 
+// Buses are independent, so their edges are built concurrently into per-bus buffers
+// and then added in bus order: edge ids are the same as with a single thread.
 void TransportRouter::InitializeEdges() {
-    for (const auto &bus : catalogue_.GetBuses()) {
-        const auto &bus_stops = bus->route;
+    const auto sorted_buses = catalogue_.GetSortedBuses();
+    const std::vector<domain::BusId> buses(sorted_buses.begin(), sorted_buses.end());
+    const std::vector<VertexIds> stop_vertexes = GetStopVertexes();
+    std::vector<BusEdges> bus_edges(buses.size());
 
-        for (size_t idx_from = 0; idx_from < bus_stops.size() - 1; ++idx_from) {
-            VertexIds vertex_from = stops_vertex_ids_.at(bus_stops[idx_from]->name);
-            size_t idx_prev = idx_from;
+    parallel::ThreadPool pool(settings_.precompute_threads);
+    pool.ParallelFor(0, buses.size(), [&](size_t idx) {
+        bus_edges[idx] = BuildBusEdges(buses[idx], stop_vertexes);
+    });
 
-            int span_count{};
-            double dist{};
+    for (size_t idx = 0; idx < buses.size(); ++idx) {
+        AddBusEdges(buses[idx], bus_edges[idx]);
+    }
+}
 
-            for (size_t idx_to = idx_from + 1; idx_to < bus_stops.size(); ++idx_to) {
-                VertexIds vertex_to = stops_vertex_ids_.at(bus_stops[idx_to]->name);
-                Time weight{};
+std::vector<graph::EdgeId> TransportRouter::AddBusEdges(domain::BusId bus,
+                                                        const BusEdges &bus_edges) {
+    std::vector<graph::EdgeId> edge_ids;
+    edge_ids.reserve(bus_edges.edges.size());
+    for (size_t idx = 0; idx < bus_edges.edges.size(); ++idx) {
+        const graph::EdgeId edge_id = graph_.AddEdge(bus_edges.edges[idx]);
+        edges_info_.insert({edge_id, bus_edges.edges_info[idx]});
+        edge_ids.push_back(edge_id);
+    }
+    bus_edge_ids_[bus] = edge_ids;
+    return edge_ids;
+}
 
-                if (bus_stops[idx_from] != bus_stops[idx_to]) {
-                    dist += catalogue_.GetDistanceBetweenStops(bus_stops[idx_prev],
-                                                               bus_stops[idx_to]);
-                    weight = (dist / settings_.bus_velocity) * TO_MINUTES;
+// Vertices of every stop id, so that the edges of a route are built without name
+// lookups. Stops without vertices get zeroes.
+std::vector<VertexIds> TransportRouter::GetStopVertexes() const {
+    std::vector<VertexIds> stop_vertexes(catalogue_.GetStopIdCount());
+    for (const auto &[name, vertex_ids] : stops_vertex_ids_) {
+        stop_vertexes[*catalogue_.GetStopId(name)] = vertex_ids;
+    }
+    return stop_vertexes;
+}
 
-                    const graph::EdgeId edge_id =
-                        graph_.AddEdge({vertex_from.out, vertex_to.in, weight});
-                    edges_info_.insert(
-                        {edge_id, BusEdgeInfo{bus->name, ++span_count, weight}});
-                }
+TransportRouter::BusEdges
+TransportRouter::BuildBusEdges(domain::BusId bus,
+                               const std::vector<VertexIds> &stop_vertexes) const {
+    const auto route = catalogue_.GetRouteStops(bus);
+    const auto bus_stops = route.begin();
+    const size_t stop_count = route.end() - route.begin();
+    std::vector<double> distances(stop_count);
+    for (size_t idx = 1; idx < stop_count; ++idx) {
+        distances[idx] =
+            catalogue_.GetDistanceBetweenStops(bus_stops[idx - 1], bus_stops[idx]);
+    }
 
-                idx_prev = idx_to;
+    const std::string_view bus_name = catalogue_.GetBus(bus)->name;
+    BusEdges bus_edges;
+    for (size_t idx_from = 0; idx_from + 1 < stop_count; ++idx_from) {
+        int span_count{};
+        double dist{};
+
+        for (size_t idx_to = idx_from + 1; idx_to < stop_count; ++idx_to) {
+            if (bus_stops[idx_from] != bus_stops[idx_to]) {
+                dist += distances[idx_to];
+                const Time weight = GetRideTime(dist, settings_.bus_velocity);
+
+                bus_edges.edges.push_back({stop_vertexes[bus_stops[idx_from]].out,
+                                           stop_vertexes[bus_stops[idx_to]].in, weight});
+                bus_edges.edges_info.push_back(
+                    BusEdgeInfo{bus_name, ++span_count, weight, dist});
             }
         }
     }
+    return bus_edges;
+}
+
+void TransportRouter::InitializeRouteStopGraph() {
+    graph_ = Graph(catalogue_.GetStopsCount());
+
+    graph::VertexId vertex_id{};
+    for (const domain::StopId stop : catalogue_.GetSortedStops()) {
+        stops_vertex_ids_[catalogue_.GetStopName(stop)] = VertexIds{vertex_id, vertex_id};
+        ++vertex_id;
+    }
+    const std::vector<VertexIds> stop_vertexes = GetStopVertexes();
+    for (const domain::BusId bus : catalogue_.GetSortedBuses()) {
+        AddRouteStopBus(bus, stop_vertexes);
+    }
+}
+
+// Edge ids stay, so edges_info_ holds as it is. Vertices added later by AddBus are
+// appended after the renumbered ones.
+void TransportRouter::RenumberVertexes() {
+    const auto new_ids = graph::ComputeReverseCuthillMcKee(CsrGraph(graph_));
+    graph_ = graph::RenumberVertices(graph_, new_ids);
+    for (auto &[name, vertex_ids] : stops_vertex_ids_) {
+        vertex_ids = {new_ids[vertex_ids.in], new_ids[vertex_ids.out]};
+    }
+}
+
+std::vector<graph::EdgeId>
+TransportRouter::AddRouteStopBus(domain::BusId bus,
+                                 const std::vector<VertexIds> &stop_vertexes) {
+    std::vector<graph::EdgeId> edge_ids;
+    const Time wait_time = settings_.bus_wait_time;
+    const std::string_view bus_name = catalogue_.GetBus(bus)->name;
+    const auto route = catalogue_.GetRouteStops(bus);
+    const auto bus_stops = route.begin();
+    const size_t stop_count = route.end() - route.begin();
+    for (size_t idx = 0; idx < stop_count; ++idx) {
+        const domain::StopId stop = bus_stops[idx];
+        const std::string_view stop_name = catalogue_.GetStopName(stop);
+        const graph::VertexId stop_vertex = stop_vertexes[stop].in;
+        const graph::VertexId route_vertex = graph_.AddVertex();
+
+        if (idx + 1 < stop_count) {
+            const graph::EdgeId edge_id =
+                graph_.AddEdge({stop_vertex, route_vertex, wait_time});
+            edges_info_.insert({edge_id, WaitEdgeInfo{stop_name, wait_time}});
+            edge_ids.push_back(edge_id);
+        }
+        if (idx > 0) {
+            const double distance =
+                catalogue_.GetDistanceBetweenStops(bus_stops[idx - 1], stop);
+            const Time weight = GetRideTime(distance, settings_.bus_velocity);
+            const graph::EdgeId ride_id =
+                graph_.AddEdge({route_vertex - 1, route_vertex, weight});
+            edges_info_.insert({ride_id, RideEdgeInfo{bus_name, distance}});
+
+            const graph::EdgeId alight_id =
+                graph_.AddEdge({route_vertex, stop_vertex, Time{}});
+            edges_info_.insert({alight_id, AlightEdgeInfo{stop_name}});
+            edge_ids.push_back(ride_id);
+            edge_ids.push_back(alight_id);
+        }
+    }
+    bus_edge_ids_[bus] = edge_ids;
+    return edge_ids;
+}
+
+std::vector<graph::EdgeId> TransportRouter::AddStopVertexes(domain::BusId bus) {
+    std::vector<graph::EdgeId> edge_ids;
+    const Time wait_time = settings_.bus_wait_time;
+    for (const domain::StopId stop : catalogue_.GetRouteStops(bus)) {
+        const std::string_view stop_name = catalogue_.GetStopName(stop);
+        if (stops_vertex_ids_.count(stop_name) > 0) {
+            continue;
+        }
+        auto &vertex_ids = stops_vertex_ids_[stop_name];
+        vertex_ids.in = graph_.AddVertex();
+        if (settings_.graph_model == GraphModel::ROUTE_STOPS) {
+            vertex_ids.out = vertex_ids.in;
+            continue;
+        }
+        vertex_ids.out = graph_.AddVertex();
+        const graph::EdgeId edge_id =
+            graph_.AddEdge({vertex_ids.in, vertex_ids.out, wait_time});
+        edges_info_.insert({edge_id, WaitEdgeInfo{stop_name, wait_time}});
+        edge_ids.push_back(edge_id);
+    }
+    return edge_ids;
+}
+
+void TransportRouter::AddBus(std::string_view bus_name) {
+    const auto bus = catalogue_.GetBusId(bus_name);
+    if (!bus) {
+        throw std::invalid_argument("Unknown bus");
+    }
+
+    ThawGraph();
+    const domain::BusId bus_id = *bus;
+    std::vector<graph::EdgeId> added = AddStopVertexes(bus_id);
+    bus_edge_ids_.resize(catalogue_.GetBusIdCount());
+    const std::vector<VertexIds> stop_vertexes = GetStopVertexes();
+    const auto bus_edge_ids = settings_.graph_model == GraphModel::ROUTE_STOPS
+                                  ? AddRouteStopBus(bus_id, stop_vertexes)
+                                  : AddBusEdges(bus_id, BuildBusEdges(bus_id, stop_vertexes));
+    added.insert(added.end(), bus_edge_ids.begin(), bus_edge_ids.end());
+    UpdateRouter(added, {});
+}
+
+// The route-stop vertices of a removed bus stay in the graph without edges.
+void TransportRouter::RemoveBus(std::string_view bus_name) {
+    const auto bus = catalogue_.GetBusId(bus_name);
+    if (!bus) {
+        return;
+    }
+    ThawGraph();
+    std::vector<graph::EdgeId> removed = std::exchange(bus_edge_ids_[*bus], {});
+    std::sort(removed.begin(), removed.end());
+    for (const graph::EdgeId edge_id : removed) {
+        graph_.RemoveEdge(edge_id);
+        edges_info_.erase(edge_id);
+    }
+    UpdateRouter({}, removed);
+    if (raptor_) {
+        raptor_->RemoveBus(bus_name);
+    }
+}
+
+// Called after the catalogue distance between the stops has changed. Only the buses
+// that drive between them in either direction are rebuilt, keeping their edge ids.
+void TransportRouter::UpdateDistance(std::string_view from, std::string_view to) {
+    const auto stop_from = catalogue_.GetStopId(from);
+    const auto stop_to = catalogue_.GetStopId(to);
+    const auto *buses = catalogue_.GetBusesByStop(from);
+    if (!stop_from || !stop_to || !buses) {
+        return;
+    }
+    ThawGraph();
+
+    std::vector<domain::BusId> affected_buses;
+    for (const auto &bus : *buses) {
+        const auto route = catalogue_.GetRouteStops(bus->id);
+        const auto bus_stops = route.begin();
+        const size_t stop_count = route.end() - route.begin();
+        for (size_t idx = 1; idx < stop_count; ++idx) {
+            if ((bus_stops[idx - 1] == *stop_from && bus_stops[idx] == *stop_to) ||
+                (bus_stops[idx - 1] == *stop_to && bus_stops[idx] == *stop_from)) {
+                affected_buses.push_back(bus->id);
+                break;
+            }
+        }
+    }
+
+    std::vector<graph::EdgeId> decreased;
+    std::vector<graph::EdgeId> increased;
+    const auto set_weight = [&](graph::EdgeId edge_id, Time weight) {
+        const Time old_weight = graph_.GetEdge(edge_id).weight;
+        if (weight < old_weight) {
+            decreased.push_back(edge_id);
+        } else if (weight > old_weight) {
+            increased.push_back(edge_id);
+        }
+        graph_.SetEdgeWeight(edge_id, weight);
+    };
+
+    // The edges of a bus are listed as they were built, so the ride edges follow the
+    // route and the bus edges follow BuildBusEdges.
+    const std::vector<VertexIds> stop_vertexes = GetStopVertexes();
+    for (const domain::BusId bus : affected_buses) {
+        const std::vector<graph::EdgeId> &edge_ids = bus_edge_ids_[bus];
+        if (settings_.graph_model == GraphModel::ROUTE_STOPS) {
+            std::vector<graph::EdgeId> ride_ids;
+            for (const graph::EdgeId edge_id : edge_ids) {
+                if (std::holds_alternative<RideEdgeInfo>(edges_info_.at(edge_id))) {
+                    ride_ids.push_back(edge_id);
+                }
+            }
+            const auto route = catalogue_.GetRouteStops(bus);
+            const auto bus_stops = route.begin();
+            if (ride_ids.size() + 1 != static_cast<size_t>(route.end() - bus_stops)) {
+                throw std::logic_error("Bus edges don't match the route");
+            }
+            for (size_t idx = 0; idx < ride_ids.size(); ++idx) {
+                const double distance =
+                    catalogue_.GetDistanceBetweenStops(bus_stops[idx], bus_stops[idx + 1]);
+                set_weight(ride_ids[idx], GetRideTime(distance, settings_.bus_velocity));
+                std::get<RideEdgeInfo>(edges_info_.at(ride_ids[idx])).distance = distance;
+            }
+        } else {
+            const BusEdges bus_edges = BuildBusEdges(bus, stop_vertexes);
+            if (edge_ids.size() != bus_edges.edges.size()) {
+                throw std::logic_error("Bus edges don't match the route");
+            }
+            for (size_t idx = 0; idx < edge_ids.size(); ++idx) {
+                set_weight(edge_ids[idx], bus_edges.edges[idx].weight);
+                edges_info_.at(edge_ids[idx]) = bus_edges.edges_info[idx];
+            }
+        }
+    }
+    UpdateRouter(decreased, increased);
+}
+
+void TransportRouter::SetRoutingSettings(const RoutingSettings &settings) {
+    if (settings.graph_model != settings_.graph_model) {
+        throw std::invalid_argument("Graph model can't be changed on a built graph");
+    }
+    if (settings.vertex_order != settings_.vertex_order) {
+        throw std::invalid_argument("Vertex order can't be changed on a built graph");
+    }
+    const RoutingSettings old_settings = std::exchange(settings_, settings);
+    ReweightEdges();
+    if (NeedsGraph(settings_.mode)) {
+        ThawGraph();
+    } else {
+        graph_ = Graph();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const bool is_customizable =
+        settings_.mode == old_settings.mode && IsCustomizable(settings_.mode) &&
+        (settings_.mode != RouterMode::LANDMARKS ||
+         settings_.landmark_count == old_settings.landmark_count);
+    if (is_customizable) {
+        Customize(*router_);
+    } else {
+        InitializeRouter();
+    }
+    ReconfigureProfiles(is_customizable);
+    precompute_stats_ = {};
+    precompute_stats_.time = std::chrono::steady_clock::now() - start;
+
+    if (settings_.verify_precompute && settings_.mode == RouterMode::ALL_PAIRS) {
+        VerifyPrecompute();
+    }
+}
+
+void TransportRouter::ReweightEdges() {
+    for (auto &[edge_id, edge_info] : edges_info_) {
+        const Time weight = GetEdgeWeight(edge_info, settings_);
+        if (auto *wait_edge = std::get_if<WaitEdgeInfo>(&edge_info)) {
+            wait_edge->time = weight;
+        } else if (auto *bus_edge = std::get_if<BusEdgeInfo>(&edge_info)) {
+            bus_edge->time = weight;
+        }
+        if (graph_.GetVertexCount() != 0) {
+            graph_.SetEdgeWeight(edge_id, weight);
+        }
+    }
+    csr_graph_ = csr_graph_.WithWeights(GetArcWeights(settings_));
+}
+
+std::vector<Time> TransportRouter::GetArcWeights(const RoutingSettings &settings) const {
+    std::vector<Time> weights(csr_graph_.GetArcCount());
+    for (size_t arc = 0; arc < weights.size(); ++arc) {
+        weights[arc] = GetEdgeWeight(edges_info_.at(csr_graph_.GetEdgeId(arc)), settings);
+    }
+    return weights;
+}
+
+Time TransportRouter::GetEdgeWeight(const EdgeInfo &edge_info,
+                                    const RoutingSettings &settings) const {
+    if (std::holds_alternative<WaitEdgeInfo>(edge_info)) {
+        return settings.bus_wait_time;
+    }
+    if (const auto *bus_edge = std::get_if<BusEdgeInfo>(&edge_info)) {
+        return GetRideTime(bus_edge->distance, settings.bus_velocity);
+    }
+    if (const auto *ride_edge = std::get_if<RideEdgeInfo>(&edge_info)) {
+        return GetRideTime(ride_edge->distance, settings.bus_velocity);
+    }
+    return Time{};
+}
+
+// Only the preprocessing follows the edited edges: all-pairs tables are repaired in
+// place, hierarchies, hub labels and landmarks are customized with their contraction
+// order or landmarks kept. New vertices, as route-stop vertices of an added bus, take a
+// full rebuild, and so do the engines that keep nothing worth patching.
+void TransportRouter::UpdateRouter(const std::vector<graph::EdgeId> &decreased,
+                                   const std::vector<graph::EdgeId> &increased) {
+    const bool is_same_vertexes = graph_.GetVertexCount() == csr_graph_.GetVertexCount();
+    FreezeGraph();
+    if (auto *table = dynamic_cast<Router *>(router_.get())) {
+        table->Update(decreased, increased);
+        InitializeSearch();
+    } else if (is_same_vertexes && IsCustomizable(settings_.mode)) {
+        Customize(*router_);
+        InitializeSearch();
+    } else {
+        InitializeRouter();
+    }
+    InitializeComponents();
+    UpdateProfiles(decreased, increased, is_same_vertexes);
 }
 
-} // namespace router
\ No newline at end of file
+} // namespace router
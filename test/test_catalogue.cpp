@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include <transport_catalogue.h>
 
+#include <algorithm>
+#include <random>
+
 using namespace std;
 using namespace tc;
 
@@ -86,4 +89,201 @@ TEST(Catalogue, NotSetDistanceBetweenStops) {
 
     ASSERT_EQ(
         0.0, tc.GetDistanceBetweenStops(tc.SearchStop(stop2.name), tc.SearchStop(stop1.name)));
-}
\ No newline at end of file
+}
+TEST(Catalogue, IdsIndexStopsAndRoutes) {
+    TransportCatalogue tc;
+
+    tc.AddStop(domain::Stop{"B"s, {38.646469, 34.657259}});
+    tc.AddStop(domain::Stop{"A"s, {38.656967, 34.890373}});
+    const auto a = tc.SearchStop("A"sv);
+    const auto b = tc.SearchStop("B"sv);
+    tc.SetDistanceBetweenStops(a, b, 1000);
+
+    domain::Bus bus;
+    bus.name = "1"s;
+    bus.route = {a, b, a};
+    bus.final_stop = b;
+    tc.AddBus(std::move(bus));
+
+    ASSERT_EQ(1u, a->id);
+    ASSERT_EQ(0u, b->id);
+    ASSERT_EQ(a->id, tc.GetStopId("A"sv));
+    ASSERT_EQ("A"sv, tc.GetStopName(a->id));
+
+    const auto bus_id = tc.GetBusId("1"sv);
+    ASSERT_TRUE(bus_id);
+    const vector<domain::StopId> route(tc.GetRouteStops(*bus_id).begin(),
+                                       tc.GetRouteStops(*bus_id).end());
+    ASSERT_EQ((vector<domain::StopId>{1, 0, 1}), route);
+    ASSERT_EQ(1000.0, tc.GetDistanceBetweenStops(b->id, a->id));
+
+    const auto stat = tc.GetBusStat("1"sv);
+    ASSERT_TRUE(stat);
+    ASSERT_EQ(3u, stat->stops_on_route);
+    ASSERT_EQ(2u, stat->unique_stops);
+    ASSERT_EQ(2000.0, stat->route_length);
+
+    tc.RemoveBus("1"sv);
+    ASSERT_FALSE(tc.GetBusId("1"sv));
+    ASSERT_TRUE(tc.IsBusRemoved(*bus_id));
+}
+
+TEST(Catalogue, FrozenDistancesResolveReversePairs) {
+    TransportCatalogue tc;
+
+    tc.AddStop(domain::Stop{"A"s, {38.656967, 34.890373}});
+    tc.AddStop(domain::Stop{"B"s, {38.646469, 34.657259}});
+    tc.AddStop(domain::Stop{"C"s, {38.636469, 34.557259}});
+    tc.SetDistanceBetweenStops("A"sv, "B"sv, 1000);
+    tc.SetDistanceBetweenStops("B"sv, "C"sv, 700);
+    tc.SetDistanceBetweenStops("C"sv, "B"sv, 900);
+    tc.FreezeDistances();
+
+    const auto id = [&tc](string_view name) {
+        return *tc.GetStopId(name);
+    };
+    ASSERT_EQ(1000.0, tc.GetDistanceBetweenStops(id("B"sv), id("A"sv)));
+    ASSERT_EQ(900.0, tc.GetDistanceBetweenStops(id("C"sv), id("B"sv)));
+    ASSERT_EQ(0.0, tc.GetDistanceBetweenStops(id("A"sv), id("C"sv)));
+
+    tc.SetDistanceBetweenStops("B"sv, "A"sv, 1200);
+    ASSERT_EQ(1200.0, tc.GetDistanceBetweenStops(id("B"sv), id("A"sv)));
+    tc.FreezeDistances();
+    ASSERT_EQ(1200.0, tc.GetDistanceBetweenStops(id("B"sv), id("A"sv)));
+    ASSERT_EQ(1000.0, tc.GetDistanceBetweenStops(id("A"sv), id("B"sv)));
+}
+
+TEST(Catalogue, StoredDistanceRowsTakePendingEdits) {
+    TransportCatalogue tc;
+    TransportCatalogue loaded;
+    for (auto *catalogue : {&tc, &loaded}) {
+        catalogue->AddStop(domain::Stop{"A"s, {38.656967, 34.890373}});
+        catalogue->AddStop(domain::Stop{"B"s, {38.646469, 34.657259}});
+        catalogue->AddStop(domain::Stop{"C"s, {38.636469, 34.557259}});
+    }
+    tc.SetDistanceBetweenStops("A"sv, "B"sv, 1000);
+    tc.SetDistanceBetweenStops("C"sv, "B"sv, 900);
+    loaded.SetDistanceIndex(tc.GetDistanceIndex().GetData());
+
+    const auto id = [&loaded](string_view name) {
+        return *loaded.GetStopId(name);
+    };
+    ASSERT_EQ(2u, loaded.GetDistanceIndex().GetData().distances.size());
+    ASSERT_EQ(1000.0, loaded.GetDistanceBetweenStops(id("B"sv), id("A"sv)));
+    ASSERT_EQ(900.0, loaded.GetDistanceBetweenStops(id("B"sv), id("C"sv)));
+
+    loaded.SetDistanceBetweenStops("B"sv, "A"sv, 1200);
+    loaded.SetDistanceBetweenStops("C"sv, "B"sv, 800);
+    ASSERT_EQ(1200.0, loaded.GetDistanceBetweenStops(id("B"sv), id("A"sv)));
+    ASSERT_EQ(1000.0, loaded.GetDistanceBetweenStops(id("A"sv), id("B"sv)));
+    ASSERT_EQ(800.0, loaded.GetDistanceBetweenStops(id("B"sv), id("C"sv)));
+    ASSERT_EQ(3u, loaded.GetDistanceIndex().GetData().distances.size());
+    ASSERT_EQ(800.0, loaded.GetDistanceBetweenStops(id("B"sv), id("C"sv)));
+}
+
+TEST(Catalogue, BusStatTableFollowsDistances) {
+    TransportCatalogue tc;
+
+    tc.AddStop(domain::Stop{"A"s, {38.656967, 34.890373}});
+    tc.AddStop(domain::Stop{"B"s, {38.646469, 34.657259}});
+    tc.SetDistanceBetweenStops("A"sv, "B"sv, 1000);
+
+    domain::Bus bus;
+    bus.name = "1"s;
+    bus.route = {tc.SearchStop("A"sv), tc.SearchStop("B"sv), tc.SearchStop("A"sv)};
+    bus.final_stop = tc.SearchStop("B"sv);
+    tc.AddBus(std::move(bus));
+    tc.ComputeBusStats(2);
+
+    ASSERT_EQ(1u, tc.GetBusStats().size());
+    ASSERT_EQ(2000.0, tc.GetBusStat("1"sv)->route_length);
+
+    tc.SetDistanceBetweenStops("B"sv, "A"sv, 1500);
+    ASSERT_EQ(2500.0, tc.GetBusStat("1"sv)->route_length);
+
+    ASSERT_THROW(tc.SetBusStats({}), invalid_argument);
+}
+
+TEST(Catalogue, SortedViewsFollowChanges) {
+    TransportCatalogue tc;
+
+    for (const auto &name : {"C"s, "A"s, "B"s}) {
+        tc.AddStop(domain::Stop{name, {38.656967, 34.890373}});
+    }
+    const auto names = [&tc](StopIdRange stops) {
+        vector<string_view> result;
+        for (const domain::StopId stop : stops) {
+            result.push_back(tc.GetStopName(stop));
+        }
+        return result;
+    };
+    ASSERT_EQ((vector<string_view>{"A"sv, "B"sv, "C"sv}), names(tc.GetSortedStops()));
+    tc.AddStop(domain::Stop{"AA"s, {38.646469, 34.657259}});
+    ASSERT_EQ((vector<string_view>{"A"sv, "AA"sv, "B"sv, "C"sv}), names(tc.GetSortedStops()));
+
+    for (const auto &name : {"2"s, "1"s, "3"s}) {
+        domain::Bus bus;
+        bus.name = name;
+        bus.route = {tc.SearchStop("A"sv), tc.SearchStop("B"sv)};
+        bus.final_stop = tc.SearchStop("B"sv);
+        tc.AddBus(std::move(bus));
+    }
+    tc.RemoveBus("2"sv);
+    vector<string> buses;
+    for (const auto &bus : tc.GetBuses()) {
+        buses.push_back(bus->name);
+    }
+    ASSERT_EQ((vector<string>{"1"s, "3"s}), buses);
+}
+
+TEST(Catalogue, NearbyStopsMatchFullScan) {
+    TransportCatalogue tc;
+
+    mt19937 generator(7);
+    uniform_real_distribution<double> lat(-80.0, 80.0);
+    uniform_real_distribution<double> lng(-180.0, 180.0);
+    uniform_real_distribution<double> shift(-0.05, 0.05);
+    for (int idx = 0; idx < 600; ++idx) {
+        // A third of the stops around the antimeridian, where longitudes wrap.
+        const geo::Coordinates point =
+            idx % 3 == 0 ? geo::Coordinates{55.0 + shift(generator),
+                                            (idx % 2 ? 180.0 : -180.0) - shift(generator)}
+                         : geo::Coordinates{lat(generator), lng(generator)};
+        tc.AddStop(domain::Stop{"S"s + to_string(idx), point});
+    }
+
+    const auto scan = [&tc](geo::Coordinates center, double radius, size_t count) {
+        vector<pair<double, domain::StopId>> stops;
+        for (domain::StopId stop = 0; stop < tc.GetStopIdCount(); ++stop) {
+            const double distance = geo::ComputeDistance(center, tc.GetStopCoordinates(stop));
+            if (distance <= radius) {
+                stops.push_back({distance, stop});
+            }
+        }
+        sort(stops.begin(), stops.end());
+        stops.resize(min(stops.size(), count));
+        NearbyStops result;
+        for (const auto &[distance, stop] : stops) {
+            result.push_back({tc.GetStopName(stop), distance});
+        }
+        return result;
+    };
+
+    const vector<geo::Coordinates> centers{
+        {55.0, 179.99}, {55.0, -179.97}, {10.0, 20.0}, {-60.0, -100.0}, {79.0, 0.0}};
+    for (const auto &center : centers) {
+        ASSERT_EQ(scan(center, 5000.0, SIZE_MAX), tc.GetNearbyStops(center, 5000.0));
+        ASSERT_EQ(scan(center, geo::SpatialIndex::NO_LIMIT, 10),
+                  tc.GetNearbyStops(center, geo::SpatialIndex::NO_LIMIT, 10));
+        ASSERT_EQ(scan(center, 2'000'000.0, 25), tc.GetNearbyStops(center, 2'000'000.0, 25));
+    }
+
+    TransportCatalogue loaded;
+    for (domain::StopId stop = 0; stop < tc.GetStopIdCount(); ++stop) {
+        const geo::Coordinates &coordinates = tc.GetStopCoordinates(stop);
+        loaded.AddStop(domain::Stop{string(tc.GetStopName(stop)), coordinates});
+    }
+    loaded.SetStopIndex(tc.GetStopIndex().GetOrder());
+    ASSERT_EQ(tc.GetNearbyStops(centers[0], 100'000.0, 7),
+              loaded.GetNearbyStops(centers[0], 100'000.0, 7));
+}
@@ -1,5 +1,1084 @@
+#include <components.h>
+#include <contraction_hierarchy.h>
+#include <csr_graph.h>
+#include <dijkstra_router.h>
 #include <gtest/gtest.h>
+#include <hub_labels.h>
+#include <landmark_router.h>
+#include <router.h>
+#include <row_cache_router.h>
+#include <transport_router.h>
+#include <vertex_order.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+using namespace std;
+using namespace graph;
+
+namespace {
+
+DirectedWeightedGraph<double> MakeRandomGraph(size_t vertex_count,
+                                              size_t edge_count,
+                                              unsigned seed) {
+    mt19937 generator(seed);
+    uniform_int_distribution<size_t> vertex(0, vertex_count - 1);
+    uniform_real_distribution<double> weight(0.0, 10.0);
+
+    DirectedWeightedGraph<double> graph(vertex_count);
+    for (size_t i = 0; i < edge_count; ++i) {
+        graph.AddEdge({vertex(generator), vertex(generator), weight(generator)});
+    }
+    return graph;
+}
+
+double GetRouteWeight(const DirectedWeightedGraph<double> &graph,
+                      VertexId from,
+                      const vector<EdgeId> &edges) {
+    double weight = 0.0;
+    VertexId vertex = from;
+    for (const EdgeId edge_id : edges) {
+        const auto &edge = graph.GetEdge(edge_id);
+        EXPECT_EQ(vertex, edge.from);
+        weight += edge.weight;
+        vertex = edge.to;
+    }
+    return weight;
+}
+
+void ExpectSameRoutes(const DirectedWeightedGraph<double> &graph,
+                      const IRouter<double> &expected_router,
+                      const IRouter<double> &router) {
+    for (VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+        for (VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+            const auto expected = expected_router.BuildRoute(from, to);
+            const auto route = router.BuildRoute(from, to);
+            ASSERT_EQ(expected.has_value(), route.has_value()) << from << " -> " << to;
+            if (!route) {
+                continue;
+            }
+            ASSERT_NEAR(expected->weight, route->weight, 1e-9);
+            ASSERT_NEAR(route->weight, GetRouteWeight(graph, from, route->edges), 1e-9);
+            if (!route->edges.empty()) {
+                ASSERT_EQ(to, graph.GetEdge(route->edges.back()).to);
+            }
+        }
+    }
+}
+
+} // namespace
 
 TEST(router, test_name) {
     ASSERT_EQ(2, 2);
-}
\ No newline at end of file
+}
+
+TEST(Graph, CsrGraphKeepsIncidenceOrder) {
+    const auto graph = MakeRandomGraph(30, 100, 7);
+    const CsrGraph<double> csr_graph(graph);
+
+    ASSERT_EQ(graph.GetVertexCount(), csr_graph.GetVertexCount());
+    ASSERT_EQ(graph.GetEdgeCount(), csr_graph.GetArcCount());
+    for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+        size_t arc = csr_graph.GetArcsBegin(vertex);
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            ASSERT_EQ(edge_id, csr_graph.GetEdgeId(arc));
+            ASSERT_EQ(graph.GetEdge(edge_id).to, csr_graph.GetTarget(arc));
+            ASSERT_EQ(graph.GetEdge(edge_id).weight, csr_graph.GetWeight(arc));
+            ++arc;
+        }
+        ASSERT_EQ(arc, csr_graph.GetArcsEnd(vertex));
+    }
+
+    const auto restored = csr_graph.ToGraph();
+    ASSERT_EQ(graph.GetVertexCount(), restored.GetVertexCount());
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        ASSERT_EQ(graph.GetEdge(edge_id).from, restored.GetEdge(edge_id).from);
+        ASSERT_EQ(graph.GetEdge(edge_id).to, restored.GetEdge(edge_id).to);
+        ASSERT_EQ(graph.GetEdge(edge_id).weight, restored.GetEdge(edge_id).weight);
+    }
+
+    auto trimmed = graph;
+    trimmed.RemoveEdge(trimmed.GetEdgeCount() - 1);
+    const CsrGraph<double> trimmed_csr(trimmed);
+    const CsrGraph<double> loaded(trimmed_csr.GetOffsets(), trimmed_csr.GetTargets(),
+                                  trimmed_csr.GetWeights(), trimmed_csr.GetEdgeIds(),
+                                  trimmed_csr.GetEdgeCount());
+    ASSERT_EQ(graph.GetEdgeCount(), loaded.ToGraph().GetEdgeCount());
+}
+
+TEST(Router, DijkstraMatchesAllPairs) {
+    for (unsigned seed = 0; seed < 5; ++seed) {
+        const auto graph = MakeRandomGraph(40, 120, seed);
+        const CsrGraph<double> csr_graph(graph);
+        ExpectSameRoutes(graph, Router<double>(graph), DijkstraRouter<double>(csr_graph));
+    }
+}
+
+TEST(Router, DijkstraUnreachable) {
+    DirectedWeightedGraph<double> graph(3);
+    graph.AddEdge({0, 1, 1.0});
+
+    const CsrGraph<double> csr_graph(graph);
+    DijkstraRouter<double> router(csr_graph);
+    ASSERT_TRUE(router.BuildRoute(0, 1));
+    ASSERT_FALSE(router.BuildRoute(1, 0));
+    ASSERT_FALSE(router.BuildRoute(0, 2));
+    ASSERT_EQ(0.0, router.BuildRoute(2, 2)->weight);
+}
+
+TEST(Graph, ComponentIndexNeverHidesRoutes) {
+    for (unsigned seed = 0; seed < 5; ++seed) {
+        // Sparse enough to fall apart into several weak and many strong components.
+        const auto graph = MakeRandomGraph(60, 50 + seed * 10, seed);
+        const ComponentIndex components{CsrGraph<double>(graph)};
+        const Router<double> router(graph);
+        for (VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+            for (VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+                const bool reachable = router.BuildRoute(from, to).has_value();
+                const bool mutual = reachable && router.BuildRoute(to, from).has_value();
+                ASSERT_TRUE(!reachable || components.MayReach(from, to)) << from << " " << to;
+                ASSERT_EQ(mutual, components.IsStronglyConnected(from, to));
+            }
+        }
+        const ComponentIndex restored(components.GetData());
+        ASSERT_EQ(components.GetWeakCount(), restored.GetWeakCount());
+        ASSERT_EQ(components.GetStrongCount(), restored.GetStrongCount());
+    }
+
+    // A loop 0 <-> 1, a one-way feeder 2 -> 0 and a depot 3 off the network.
+    DirectedWeightedGraph<double> graph(4);
+    graph.AddEdge({0, 1, 1.0});
+    graph.AddEdge({1, 0, 1.0});
+    graph.AddEdge({2, 0, 1.0});
+    const ComponentIndex components{CsrGraph<double>(graph)};
+    ASSERT_EQ(2u, components.GetWeakCount());
+    ASSERT_EQ(3u, components.GetStrongCount());
+    ASSERT_TRUE(components.MayReach(2, 1));
+    ASSERT_FALSE(components.MayReach(1, 2));
+    ASSERT_FALSE(components.MayReach(0, 3));
+    ASSERT_FALSE(components.MayReach(3, 0));
+}
+
+TEST(Graph, RenumberedGraphKeepsRoutes) {
+    for (unsigned seed = 0; seed < 5; ++seed) {
+        const auto graph = MakeRandomGraph(40, 100, seed);
+        const auto new_ids = ComputeReverseCuthillMcKee(CsrGraph<double>(graph));
+        vector<VertexId> sorted_ids = new_ids;
+        sort(sorted_ids.begin(), sorted_ids.end());
+        for (VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+            ASSERT_EQ(vertex, sorted_ids[vertex]);
+        }
+
+        const auto renumbered = RenumberVertices(graph, new_ids);
+        ASSERT_EQ(graph.GetEdgeCount(), renumbered.GetEdgeCount());
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            ASSERT_EQ(new_ids[graph.GetEdge(edge_id).from], renumbered.GetEdge(edge_id).from);
+            ASSERT_EQ(new_ids[graph.GetEdge(edge_id).to], renumbered.GetEdge(edge_id).to);
+        }
+        const Router<double> router(graph);
+        const Router<double> renumbered_router(renumbered);
+        for (VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+            for (VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+                const auto expected = router.BuildRoute(from, to);
+                const auto route = renumbered_router.BuildRoute(new_ids[from], new_ids[to]);
+                ASSERT_EQ(expected.has_value(), route.has_value());
+                if (route) {
+                    ASSERT_NEAR(expected->weight, route->weight, 1e-9);
+                }
+            }
+        }
+    }
+
+    // A path with shuffled ids comes back with neighbours one id apart.
+    constexpr size_t PATH_LENGTH = 50;
+    vector<VertexId> labels(PATH_LENGTH);
+    iota(labels.begin(), labels.end(), 0);
+    shuffle(labels.begin(), labels.end(), mt19937(3));
+    DirectedWeightedGraph<double> path(PATH_LENGTH);
+    for (size_t idx = 0; idx + 1 < PATH_LENGTH; ++idx) {
+        path.AddEdge({labels[idx], labels[idx + 1], 1.0});
+    }
+    const auto new_ids = ComputeReverseCuthillMcKee(CsrGraph<double>(path));
+    for (const auto &edge : path.GetEdges()) {
+        const VertexId from = new_ids[edge.from];
+        const VertexId to = new_ids[edge.to];
+        ASSERT_EQ(1u, max(from, to) - min(from, to));
+    }
+}
+
+TEST(Router, AStarMatchesDijkstraAndSettlesLess) {
+    constexpr size_t SIDE = 30;
+    mt19937 generator(7);
+    uniform_real_distribution<double> detour(1.0, 1.5);
+    const auto distance = [](VertexId lhs, VertexId rhs) {
+        return hypot(double(lhs % SIDE) - double(rhs % SIDE),
+                     double(lhs / SIDE) - double(rhs / SIDE));
+    };
+
+    DirectedWeightedGraph<double> graph(SIDE * SIDE);
+    for (VertexId vertex = 0; vertex < SIDE * SIDE; ++vertex) {
+        for (const VertexId neighbour : {vertex + 1, vertex + SIDE}) {
+            const bool wraps = neighbour == vertex + 1 && neighbour % SIDE == 0;
+            if (neighbour >= SIDE * SIDE || wraps) {
+                continue;
+            }
+            const double length = distance(vertex, neighbour);
+            graph.AddEdge({vertex, neighbour, length * detour(generator)});
+            graph.AddEdge({neighbour, vertex, length * detour(generator)});
+        }
+    }
+    const CsrGraph<double> csr_graph(graph);
+    const DijkstraRouter<double> dijkstra(csr_graph);
+    const DijkstraRouter<double> a_star(csr_graph, distance);
+
+    size_t dijkstra_settled = 0;
+    size_t a_star_settled = 0;
+    for (VertexId from = 0; from < SIDE * SIDE; from += 37) {
+        for (VertexId to = 0; to < SIDE * SIDE; to += 41) {
+            const auto expected = dijkstra.BuildRoute(from, to);
+            dijkstra_settled += dijkstra.GetLastSettledCount();
+            const auto route = a_star.BuildRoute(from, to);
+            a_star_settled += a_star.GetLastSettledCount();
+            ASSERT_TRUE(expected && route);
+            ASSERT_NEAR(expected->weight, route->weight, 1e-9);
+            ASSERT_NEAR(route->weight, GetRouteWeight(graph, from, route->edges), 1e-9);
+        }
+    }
+    ASSERT_LT(a_star_settled * 2, dijkstra_settled);
+}
+
+TEST(Router, LandmarksMatchAllPairs) {
+    for (unsigned seed = 0; seed < 5; ++seed) {
+        const auto graph = MakeRandomGraph(60, 200, seed);
+        const CsrGraph<double> csr_graph(graph);
+        const LandmarkRouter<double> landmarks(csr_graph, 4);
+        ExpectSameRoutes(graph, Router<double>(graph), landmarks);
+        const LandmarkRouter<double> restored(csr_graph, landmarks.GetData());
+        ExpectSameRoutes(graph, landmarks, restored);
+    }
+}
+
+TEST(Router, RowCacheMatchesAllPairs) {
+    const auto graph = MakeRandomGraph(60, 200, 4);
+    const CsrGraph<double> csr_graph(graph);
+    const Router<double> all_pairs(graph);
+    // Room for three rows of 60 weights and edge ids.
+    const RowCacheRouter<double> row_cache(csr_graph,
+                                           3 * 60 * (sizeof(double) + sizeof(EdgeId)));
+    ASSERT_EQ(3u, row_cache.GetCapacity());
+    ExpectSameRoutes(graph, all_pairs, row_cache);
+    ASSERT_EQ(3u, row_cache.GetCachedRowCount());
+    ASSERT_EQ(60u, row_cache.GetMissCount());
+
+    // Sources 57..59 are cached, using 57 makes 58 the least recently used one.
+    row_cache.BuildRoute(57, 0);
+    row_cache.BuildWeights(0, {1, 2});
+    ASSERT_EQ(61u, row_cache.GetMissCount());
+    row_cache.BuildRoute(57, 1);
+    row_cache.BuildRoute(59, 1);
+    ASSERT_EQ(61u, row_cache.GetMissCount());
+    row_cache.BuildRoute(58, 1);
+    ASSERT_EQ(62u, row_cache.GetMissCount());
+}
+
+TEST(Router, BuildWeightsMatchesBuildRoute) {
+    const auto graph = MakeRandomGraph(50, 150, 11);
+    const CsrGraph<double> csr_graph(graph);
+    const Router<double> table(graph);
+    const DijkstraRouter<double> dijkstra(csr_graph);
+    const LandmarkRouter<double> landmarks(csr_graph, 4);
+    const ContractionHierarchy<double> hierarchy(graph);
+
+    vector<VertexId> targets;
+    for (VertexId vertex = 0; vertex < graph.GetVertexCount(); vertex += 3) {
+        targets.push_back(vertex);
+    }
+    targets.push_back(targets.front());
+    for (VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+        dijkstra.BuildWeights(from, {from});
+        ASSERT_EQ(1u, dijkstra.GetLastSettledCount());
+        for (const IRouter<double> *router :
+             initializer_list<const IRouter<double> *>{&table, &dijkstra, &landmarks,
+                                                        &hierarchy}) {
+            const auto weights = router->BuildWeights(from, targets);
+            ASSERT_EQ(targets.size(), weights.size());
+            for (size_t idx = 0; idx < targets.size(); ++idx) {
+                const auto route = table.BuildRoute(from, targets[idx]);
+                ASSERT_EQ(route.has_value(), weights[idx].has_value());
+                if (route) {
+                    ASSERT_NEAR(route->weight, *weights[idx], 1e-9);
+                }
+            }
+        }
+    }
+}
+
+TEST(Router, ContractionHierarchyMatchesAllPairs) {
+    for (unsigned seed = 0; seed < 5; ++seed) {
+        const auto graph = MakeRandomGraph(60, 200, seed);
+        ExpectSameRoutes(graph, Router<double>(graph), ContractionHierarchy<double>(graph));
+    }
+}
+
+TEST(Router, ContractionHierarchyFromData) {
+    const auto graph = MakeRandomGraph(50, 150, 42);
+    ContractionHierarchy<double> hierarchy(graph);
+    ContractionHierarchy<double> restored(graph, hierarchy.GetData());
+    ExpectSameRoutes(graph, hierarchy, restored);
+}
+
+TEST(Router, HubLabelsMatchAllPairs) {
+    for (unsigned seed = 0; seed < 5; ++seed) {
+        const auto graph = MakeRandomGraph(60, 200, seed);
+        const HubLabels<double> hub_labels(graph);
+        ExpectSameRoutes(graph, Router<double>(graph), hub_labels);
+        const auto &hierarchy_data = hub_labels.GetHierarchy().GetData();
+        const HubLabels<double> rebuilt(graph, hierarchy_data);
+        ASSERT_EQ(hub_labels.GetData().forward.hubs, rebuilt.GetData().forward.hubs);
+        ASSERT_EQ(hub_labels.GetData().backward.hubs, rebuilt.GetData().backward.hubs);
+        const HubLabels<double> restored(graph, hierarchy_data, hub_labels.GetData());
+        ExpectSameRoutes(graph, hub_labels, restored);
+    }
+}
+
+TEST(Router, CustomizedHierarchyMatchesAllPairs) {
+    auto graph = MakeRandomGraph(60, 200, 5);
+    ContractionHierarchy<double> hierarchy(graph);
+    LandmarkRouter<double>::Data landmarks_data;
+    {
+        const CsrGraph<double> csr_graph(graph);
+        landmarks_data = LandmarkRouter<double>(csr_graph, 4).GetData();
+    }
+
+    mt19937 generator(17);
+    uniform_real_distribution<double> weight(0.0, 10.0);
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        graph.SetEdgeWeight(edge_id, weight(generator));
+    }
+    hierarchy.Customize();
+    ExpectSameRoutes(graph, Router<double>(graph), hierarchy);
+
+    HubLabels<double> hub_labels(graph, hierarchy.GetData());
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        graph.SetEdgeWeight(edge_id, weight(generator));
+    }
+    hub_labels.Customize();
+    ExpectSameRoutes(graph, Router<double>(graph), hub_labels);
+
+    const CsrGraph<double> csr_graph(graph);
+    LandmarkRouter<double> landmarks(csr_graph, landmarks_data);
+    landmarks.Customize();
+    ExpectSameRoutes(graph, Router<double>(graph), landmarks);
+}
+
+TEST(Router, PrecomputeVariantsAreBitIdentical) {
+    auto graph = MakeRandomGraph(150, 600, 3);
+    // Whole weights then make ties, which every variant breaks as the sequential loop does.
+    for (const bool is_rounded : {false, true}) {
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount() && is_rounded; ++edge_id) {
+            graph.SetEdgeWeight(edge_id, round(graph.GetEdge(edge_id).weight));
+        }
+        const Router<double> sequential(graph);
+        const auto &expected = sequential.GetRoutesInternalData();
+
+        for (const auto precompute : {RoutesPrecompute::PARALLEL, RoutesPrecompute::BLOCKED}) {
+            for (size_t thread_count = 1; thread_count <= 4; ++thread_count) {
+                const Router<double> router(graph, precompute, thread_count);
+                const auto &internal_data = router.GetRoutesInternalData();
+                ASSERT_EQ(expected.vertex_count, internal_data.vertex_count);
+                ASSERT_EQ(expected.prev_edges, internal_data.prev_edges);
+                ASSERT_EQ(expected.weights, internal_data.weights);
+            }
+        }
+    }
+}
+
+TEST(Router, SimdRelaxRowMatchesScalarLoop) {
+    constexpr uint32_t UNREACHABLE = Router<double>::RoutesInternalData::UNREACHABLE;
+    constexpr uint32_t NO_PREV_EDGE = Router<double>::RoutesInternalData::NO_PREV_EDGE;
+    constexpr size_t ROW_SIZE = 37;
+    mt19937 generator(5);
+    uniform_int_distribution<uint32_t> prev_edge(0, 5);
+    uniform_int_distribution<int> weight(0, 20);
+
+    // Small integer weights make ties, prev_edge values 4 and 5 stand for the markers.
+    const auto make_prev = [&]() {
+        const uint32_t prev = prev_edge(generator);
+        return prev == 4 ? UNREACHABLE : prev == 5 ? NO_PREV_EDGE : prev;
+    };
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        vector<double> weights_through(ROW_SIZE);
+        vector<uint32_t> prev_through(ROW_SIZE);
+        vector<double> weights_row(ROW_SIZE);
+        vector<uint32_t> prev_row(ROW_SIZE);
+        for (size_t idx = 0; idx < ROW_SIZE; ++idx) {
+            weights_through[idx] = weight(generator);
+            prev_through[idx] = make_prev();
+            weights_row[idx] = weight(generator);
+            prev_row[idx] = make_prev();
+        }
+        const double weight_from = weight(generator) / 2.0;
+        const uint32_t prev_from = prev_edge(generator);
+        const size_t begin = iteration % 3;
+
+        auto expected_weights = weights_row;
+        auto expected_prevs = prev_row;
+        for (size_t idx = begin; idx < ROW_SIZE; ++idx) {
+            const double candidate = weight_from + weights_through[idx];
+            if (prev_through[idx] != UNREACHABLE &&
+                (expected_prevs[idx] == UNREACHABLE || candidate < expected_weights[idx])) {
+                expected_weights[idx] = candidate;
+                expected_prevs[idx] =
+                    prev_through[idx] != NO_PREV_EDGE ? prev_through[idx] : prev_from;
+            }
+        }
+
+        // Every kernel the CPU runs, not only the one RelaxRowSimd picks.
+        vector<decltype(&detail::RelaxRowSimd)> kernels = {&detail::RelaxRowSimd};
+#if defined(__SSE2__)
+        kernels.push_back(&detail::RelaxRowSse2);
+#endif
+#if defined(GRAPH_MIN_PLUS_AVX2)
+        if (detail::HasAvx2()) {
+            kernels.push_back(&detail::RelaxRowAvx2);
+        }
+#endif
+        for (const auto kernel : kernels) {
+            auto kernel_weights = weights_row;
+            auto kernel_prevs = prev_row;
+            const size_t end =
+                kernel(weight_from, prev_from, weights_through.data(), prev_through.data(),
+                       kernel_weights.data(), kernel_prevs.data(), begin, ROW_SIZE,
+                       UNREACHABLE, NO_PREV_EDGE);
+            ASSERT_LE(end, ROW_SIZE);
+            for (size_t idx = begin; idx < end; ++idx) {
+                ASSERT_EQ(expected_weights[idx], kernel_weights[idx]) << idx;
+                ASSERT_EQ(expected_prevs[idx], kernel_prevs[idx]) << idx;
+            }
+        }
+    }
+}
+
+TEST(Router, SimdRelaxTileMatchesScalarLoop) {
+    constexpr uint32_t UNREACHABLE = Router<double>::RoutesInternalData::UNREACHABLE;
+    constexpr uint32_t NO_PREV_EDGE = Router<double>::RoutesInternalData::NO_PREV_EDGE;
+    constexpr double INFINITE = numeric_limits<double>::infinity();
+    constexpr size_t SIZE = detail::PANEL_SIZE;
+    if (!detail::HasTileKernel()) {
+        GTEST_SKIP();
+    }
+    mt19937 generator(7);
+    uniform_int_distribution<uint32_t> prev_edge(0, 5);
+    uniform_int_distribution<int> weight(0, 20);
+
+    // The kernels see unreachable cells as infinite weights, prev_edge values 4 and 5
+    // stand for the markers and small integer weights make ties.
+    const auto fill = [&](vector<double> &weights, vector<uint32_t> &prevs) {
+        for (size_t idx = 0; idx < weights.size(); ++idx) {
+            const uint32_t prev = prev_edge(generator);
+            prevs[idx] = prev == 4 ? UNREACHABLE : prev == 5 ? NO_PREV_EDGE : prev;
+            weights[idx] = prevs[idx] == UNREACHABLE ? INFINITE : weight(generator);
+        }
+    };
+    const auto relax = [&](double weight_from,
+                           uint32_t prev_from,
+                           const double *weights_through,
+                           const uint32_t *prevs_through,
+                           double *weights_row,
+                           uint32_t *prev_row,
+                           size_t cell_count) {
+        for (size_t cell = 0; cell < cell_count; ++cell) {
+            const double candidate = weight_from + weights_through[cell];
+            if (candidate < weights_row[cell]) {
+                weights_row[cell] = candidate;
+                prev_row[cell] =
+                    prevs_through[cell] != NO_PREV_EDGE ? prevs_through[cell] : prev_from;
+            }
+        }
+    };
+
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        vector<double> through_weights(SIZE * SIZE);
+        vector<uint32_t> through_prevs(SIZE * SIZE);
+        fill(through_weights, through_prevs);
+        for (size_t through = 0; through < SIZE; ++through) {
+            through_weights[through * SIZE + through] = 0.0;
+            through_prevs[through * SIZE + through] = NO_PREV_EDGE;
+        }
+        vector<double> weights_row(SIZE);
+        vector<uint32_t> prev_row(SIZE);
+        fill(weights_row, prev_row);
+        vector<double> column_weights(SIZE);
+        vector<uint32_t> column_prevs(SIZE);
+        fill(column_weights, column_prevs);
+        vector<uint32_t> throughs;
+        for (uint32_t through = 0; through < SIZE; ++through) {
+            if (column_prevs[through] != UNREACHABLE) {
+                throughs.push_back(through);
+            }
+        }
+        const size_t cell_count = SIZE - iteration % 7;
+
+        auto expected_weights = weights_row;
+        auto expected_prevs = prev_row;
+        for (const uint32_t through : throughs) {
+            relax(column_weights[through], column_prevs[through],
+                  &through_weights[through * SIZE], &through_prevs[through * SIZE],
+                  expected_weights.data(), expected_prevs.data(), cell_count);
+        }
+        vector<decltype(&detail::RelaxTileRowSimd)> kernels = {&detail::RelaxTileRowSimd};
+#if defined(GRAPH_MIN_PLUS_AVX2)
+        kernels.push_back(&detail::RelaxTileRowAvx2);
+        if (detail::HasAvx512()) {
+            kernels.push_back(&detail::RelaxTileRowAvx512);
+        }
+#endif
+        for (const auto kernel : kernels) {
+            auto kernel_weights = weights_row;
+            auto kernel_prevs = prev_row;
+            kernel(column_weights.data(), column_prevs.data(), through_weights.data(),
+                   through_prevs.data(), SIZE, throughs.data(), throughs.size(),
+                   kernel_weights.data(), kernel_prevs.data(), cell_count, NO_PREV_EDGE);
+            ASSERT_EQ(expected_weights, kernel_weights);
+            ASSERT_EQ(expected_prevs, kernel_prevs);
+        }
+
+        if (!detail::HasPanelKernel()) {
+            continue;
+        }
+        // The panel takes the route to through vertex k from cell k at its turn.
+        expected_weights = weights_row;
+        expected_prevs = prev_row;
+        vector<double> expected_column_weights(SIZE);
+        vector<uint32_t> expected_column_prevs(SIZE);
+        for (size_t through = 0; through < SIZE; ++through) {
+            expected_column_weights[through] = expected_weights[through];
+            expected_column_prevs[through] = expected_prevs[through];
+            relax(expected_weights[through], expected_prevs[through],
+                  &through_weights[through * SIZE], &through_prevs[through * SIZE],
+                  expected_weights.data(), expected_prevs.data(), SIZE);
+        }
+        auto kernel_weights = weights_row;
+        auto kernel_prevs = prev_row;
+        detail::RelaxPanelRowSimd(through_weights.data(), through_prevs.data(),
+                                  kernel_weights.data(), kernel_prevs.data(),
+                                  column_weights.data(), column_prevs.data(), NO_PREV_EDGE);
+        ASSERT_EQ(expected_weights, kernel_weights);
+        ASSERT_EQ(expected_prevs, kernel_prevs);
+        ASSERT_EQ(expected_column_weights, column_weights);
+        ASSERT_EQ(expected_column_prevs, column_prevs);
+    }
+}
+
+TEST(Router, UpdateMatchesRebuild) {
+    auto graph = MakeRandomGraph(40, 120, 7);
+    Router<double> router(graph);
+    mt19937 generator(11);
+    uniform_real_distribution<double> weight(0.0, 10.0);
+    vector<bool> is_removed(graph.GetEdgeCount(), false);
+
+    for (int step = 0; step < 20; ++step) {
+        vector<EdgeId> decreased;
+        vector<EdgeId> increased;
+        if (step % 4 == 0) {
+            graph.AddVertex();
+        }
+        uniform_int_distribution<size_t> vertex(0, graph.GetVertexCount() - 1);
+        for (int idx = 0; idx < 3; ++idx) {
+            decreased.push_back(
+                graph.AddEdge({vertex(generator), vertex(generator), weight(generator)}));
+            is_removed.push_back(false);
+        }
+        uniform_int_distribution<EdgeId> edge(0, graph.GetEdgeCount() - 1);
+        for (int idx = 0; idx < 4; ++idx) {
+            const EdgeId edge_id = edge(generator);
+            if (is_removed[edge_id] || count(decreased.begin(), decreased.end(), edge_id) ||
+                count(increased.begin(), increased.end(), edge_id)) {
+                continue;
+            }
+            if (idx == 0) {
+                graph.RemoveEdge(edge_id);
+                is_removed[edge_id] = true;
+                increased.push_back(edge_id);
+                continue;
+            }
+            const double old_weight = graph.GetEdge(edge_id).weight;
+            const double new_weight = weight(generator);
+            graph.SetEdgeWeight(edge_id, new_weight);
+            (new_weight < old_weight ? decreased : increased).push_back(edge_id);
+        }
+
+        router.Update(decreased, increased);
+        ExpectSameRoutes(graph, Router<double>(graph), router);
+        for (VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+            for (VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+                if (const auto route = router.BuildRoute(from, to)) {
+                    for (const EdgeId edge_id : route->edges) {
+                        ASSERT_FALSE(is_removed[edge_id]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+namespace {
+
+void AddBus(tc::TransportCatalogue &catalogue,
+            string name,
+            const vector<string_view> &names,
+            bool roundtrip) {
+    domain::Bus bus{move(name), {}, roundtrip, nullptr};
+    bus.route.reserve(names.size() * 2);
+    for (const auto stop_name : names) {
+        bus.route.push_back(catalogue.SearchStop(stop_name));
+    }
+    bus.final_stop = bus.route.back();
+    if (!roundtrip) {
+        bus.route.insert(bus.route.end(), ++bus.route.rbegin(), bus.route.rend());
+    }
+    catalogue.AddBus(move(bus));
+}
+
+tc::TransportCatalogue MakeCatalogue() {
+    tc::TransportCatalogue catalogue;
+    const vector<pair<string, geo::Coordinates>> stops = {{"A"s, {55.60, 37.20}},
+                                                          {"B"s, {55.61, 37.21}},
+                                                          {"C"s, {55.62, 37.22}},
+                                                          {"D"s, {55.63, 37.23}},
+                                                          {"E"s, {55.64, 37.24}}};
+    for (const auto &[name, coordinates] : stops) {
+        catalogue.AddStop(domain::Stop{name, coordinates});
+    }
+    catalogue.SetDistanceBetweenStops("A"sv, "B"sv, 1300);
+    catalogue.SetDistanceBetweenStops("B"sv, "C"sv, 1700);
+    catalogue.SetDistanceBetweenStops("C"sv, "D"sv, 1900);
+    catalogue.SetDistanceBetweenStops("D"sv, "C"sv, 2300);
+    catalogue.SetDistanceBetweenStops("B"sv, "E"sv, 5100);
+    catalogue.SetDistanceBetweenStops("E"sv, "D"sv, 700);
+    catalogue.SetDistanceBetweenStops("D"sv, "A"sv, 9900);
+
+    AddBus(catalogue, "1"s, {"A"sv, "B"sv, "C"sv, "D"sv}, false);
+    AddBus(catalogue, "2"s, {"B"sv, "E"sv, "D"sv, "A"sv, "B"sv}, true);
+    return catalogue;
+}
+
+void ExpectIncrementalMatchesRebuild(const router::RoutingSettings &settings) {
+    auto catalogue = MakeCatalogue();
+    router::TransportRouter incremental(catalogue, settings);
+
+    catalogue.AddStop(domain::Stop{"F"s, {55.65, 37.25}});
+    catalogue.SetDistanceBetweenStops("E"sv, "F"sv, 800);
+    catalogue.SetDistanceBetweenStops("F"sv, "C"sv, 600);
+    AddBus(catalogue, "3"s, {"E"sv, "F"sv, "C"sv}, false);
+    incremental.AddBus("3"sv);
+
+    catalogue.SetDistanceBetweenStops("C"sv, "D"sv, 900);
+    incremental.UpdateDistance("C"sv, "D"sv);
+    catalogue.SetDistanceBetweenStops("B"sv, "C"sv, 4000);
+    incremental.UpdateDistance("B"sv, "C"sv);
+
+    incremental.RemoveBus("2"sv);
+    catalogue.RemoveBus("2"sv);
+
+    const router::TransportRouter rebuilt(catalogue, settings);
+    vector<string_view> profiles = {""sv};
+    for (const auto &profile : settings.profiles) {
+        profiles.push_back(profile.name);
+    }
+    for (const auto profile : profiles) {
+        for (const auto from : {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv, "F"sv}) {
+            for (const auto to : {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv, "F"sv}) {
+                const auto expected = rebuilt.GetRouteInfo(from, to, profile);
+                const auto route = incremental.GetRouteInfo(from, to, profile);
+                ASSERT_EQ(expected.has_value(), route.has_value())
+                    << profile << ": " << from << " -> " << to;
+                if (route) {
+                    ASSERT_NEAR(expected->first, route->first, 1e-9)
+                        << profile << ": " << from << " -> " << to;
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+TEST(TransportRouter, RouteStopsModelKeepsItems) {
+    const auto catalogue = MakeCatalogue();
+    router::RoutingSettings stop_pairs_settings{6, 40};
+    router::RoutingSettings route_stops_settings = stop_pairs_settings;
+    route_stops_settings.graph_model = router::GraphModel::ROUTE_STOPS;
+    route_stops_settings.mode = router::RouterMode::DIJKSTRA;
+
+    const router::TransportRouter stop_pairs(catalogue, stop_pairs_settings);
+    const router::TransportRouter route_stops(catalogue, route_stops_settings);
+    ASSERT_LT(route_stops.GetCsrGraph().GetArcCount(), stop_pairs.GetCsrGraph().GetArcCount());
+
+    for (const auto from : {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv}) {
+        for (const auto to : {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv}) {
+            const auto expected = stop_pairs.GetRouteInfo(from, to);
+            const auto route = route_stops.GetRouteInfo(from, to);
+            ASSERT_EQ(expected.has_value(), route.has_value());
+            if (!route) {
+                continue;
+            }
+            ASSERT_NEAR(expected->first, route->first, 1e-9);
+            ASSERT_EQ(expected->second.size(), route->second.size());
+            for (size_t idx = 0; idx < route->second.size(); ++idx) {
+                const auto &expected_item = expected->second[idx];
+                const auto &item = route->second[idx];
+                ASSERT_EQ(expected_item.index(), item.index());
+                if (const auto *bus = get_if<router::BusEdgeInfo>(&item)) {
+                    const auto &expected_bus = get<router::BusEdgeInfo>(expected_item);
+                    ASSERT_EQ(expected_bus.name, bus->name);
+                    ASSERT_EQ(expected_bus.span_count, bus->span_count);
+                    ASSERT_EQ(expected_bus.time, bus->time);
+                } else {
+                    const auto &wait = get<router::WaitEdgeInfo>(item);
+                    ASSERT_EQ(get<router::WaitEdgeInfo>(expected_item).name, wait.name);
+                    ASSERT_EQ(get<router::WaitEdgeInfo>(expected_item).time, wait.time);
+                }
+            }
+        }
+    }
+}
+
+TEST(TransportRouter, AStarOnRouteStopsMatchesDijkstra) {
+    tc::TransportCatalogue catalogue;
+    const vector<pair<string, geo::Coordinates>> stops = {{"S"s, {43.000, 39.0}},
+                                                          {"X"s, {43.005, 39.0}},
+                                                          {"T"s, {43.009, 39.0}},
+                                                          {"U"s, {43.050, 39.0}}};
+    for (const auto &[name, coordinates] : stops) {
+        catalogue.AddStop(domain::Stop{name, coordinates});
+    }
+    catalogue.SetDistanceBetweenStops("S"sv, "T"sv, 1000);
+    catalogue.SetDistanceBetweenStops("S"sv, "X"sv, 1000);
+    catalogue.SetDistanceBetweenStops("X"sv, "T"sv, 400);
+    catalogue.SetDistanceBetweenStops("T"sv, "U"sv, 5000);
+    AddBus(catalogue, "1"s, {"S"sv, "T"sv}, true);
+    AddBus(catalogue, "2"s, {"S"sv, "X"sv, "T"sv, "U"sv}, true);
+
+    router::RoutingSettings dijkstra_settings{6, 60};
+    dijkstra_settings.mode = router::RouterMode::DIJKSTRA;
+    dijkstra_settings.graph_model = router::GraphModel::ROUTE_STOPS;
+    router::RoutingSettings a_star_settings = dijkstra_settings;
+    a_star_settings.mode = router::RouterMode::A_STAR;
+
+    const router::TransportRouter dijkstra(catalogue, dijkstra_settings);
+    const router::TransportRouter a_star(catalogue, a_star_settings);
+    for (const auto &[from, from_coordinates] : stops) {
+        for (const auto &[to, to_coordinates] : stops) {
+            const auto expected = dijkstra.GetRouteInfo(from, to);
+            const auto route = a_star.GetRouteInfo(from, to);
+            ASSERT_EQ(expected.has_value(), route.has_value()) << from << " -> " << to;
+            if (route) {
+                ASSERT_NEAR(expected->first, route->first, 1e-9) << from << " -> " << to;
+            }
+        }
+    }
+    ASSERT_NEAR(7, a_star.GetRouteInfo("S"sv, "T"sv)->first, 1e-9);
+}
+
+TEST(TransportRouter, RaptorMatchesDijkstra) {
+    const auto catalogue = MakeCatalogue();
+    router::RoutingSettings dijkstra_settings{6, 40};
+    dijkstra_settings.mode = router::RouterMode::DIJKSTRA;
+    router::RoutingSettings raptor_settings = dijkstra_settings;
+    raptor_settings.mode = router::RouterMode::RAPTOR;
+
+    const router::TransportRouter dijkstra(catalogue, dijkstra_settings);
+    const router::TransportRouter raptor(catalogue, raptor_settings);
+    const vector<string_view> stops = {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv};
+    for (const auto from : stops) {
+        for (const auto to : stops) {
+            const auto expected = dijkstra.GetRouteInfo(from, to);
+            const auto route = raptor.GetRouteInfo(from, to);
+            ASSERT_EQ(expected.has_value(), route.has_value());
+            if (!route) {
+                continue;
+            }
+            ASSERT_EQ(expected->first, route->first) << from << " -> " << to;
+            ASSERT_EQ(expected->second.size(), route->second.size());
+            for (size_t idx = 0; idx < route->second.size(); ++idx) {
+                const auto &expected_item = expected->second[idx];
+                const auto &item = route->second[idx];
+                ASSERT_EQ(expected_item.index(), item.index());
+                if (const auto *bus = get_if<router::BusEdgeInfo>(&item)) {
+                    const auto &expected_bus = get<router::BusEdgeInfo>(expected_item);
+                    ASSERT_EQ(expected_bus.name, bus->name);
+                    ASSERT_EQ(expected_bus.span_count, bus->span_count);
+                    ASSERT_EQ(expected_bus.time, bus->time);
+                } else {
+                    ASSERT_EQ(get<router::WaitEdgeInfo>(expected_item).name,
+                              get<router::WaitEdgeInfo>(item).name);
+                }
+            }
+        }
+    }
+
+    const vector<string_view> targets = {"C"sv, "Z"sv, "A"sv};
+    const auto times = raptor.GetTravelTimes({"A"sv, "Z"sv, "E"sv}, targets);
+    const auto expected_times = dijkstra.GetTravelTimes({"A"sv, "Z"sv, "E"sv}, targets);
+    ASSERT_EQ(expected_times, times);
+}
+
+TEST(TransportRouter, ReachableMatchesTravelTimes) {
+    const auto catalogue = MakeCatalogue();
+    const vector<string_view> stops = {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv};
+    for (const auto mode : {router::RouterMode::ALL_PAIRS, router::RouterMode::DIJKSTRA,
+                            router::RouterMode::RAPTOR}) {
+        for (const auto graph_model :
+             {router::GraphModel::STOP_PAIRS, router::GraphModel::ROUTE_STOPS}) {
+            router::RoutingSettings settings{6, 40};
+            settings.mode = mode;
+            settings.graph_model = graph_model;
+            settings.profiles = {{"peak"s, 10, 20}};
+            const router::TransportRouter transport_router(catalogue, settings);
+            ASSERT_FALSE(transport_router.GetReachableStops("Z"sv, 30));
+            ASSERT_FALSE(transport_router.GetReachableStops("A"sv, 30, "unknown"sv));
+
+            for (const auto profile : {""sv, "peak"sv}) {
+                const auto times = transport_router.GetTravelTimes(stops, stops, profile);
+                for (size_t row = 0; row < stops.size(); ++row) {
+                    const auto reachable =
+                        transport_router.GetReachableStops(stops[row], 30, profile);
+                    ASSERT_TRUE(reachable);
+                    ASSERT_TRUE(is_sorted(reachable->begin(), reachable->end(),
+                                          [](const auto &lhs, const auto &rhs) {
+                                              return lhs.second < rhs.second;
+                                          }));
+                    size_t expected_count = 0;
+                    for (size_t column = 0; column < stops.size(); ++column) {
+                        const auto &time = times[row][column];
+                        if (!time || *time > 30) {
+                            continue;
+                        }
+                        ++expected_count;
+                        const auto it = find_if(
+                            reachable->begin(), reachable->end(),
+                            [&](const auto &item) { return item.first == stops[column]; });
+                        ASSERT_NE(reachable->end(), it);
+                        ASSERT_NEAR(*time, it->second, 1e-9);
+                    }
+                    ASSERT_EQ(expected_count, reachable->size());
+                }
+            }
+        }
+    }
+}
+
+TEST(TransportRouter, BusEdgeIdsFollowTheRoute) {
+    const auto catalogue = MakeCatalogue();
+    const domain::BusId bus = *catalogue.GetBusId("2"sv);
+    const auto route = catalogue.GetRouteStops(bus);
+    const vector<domain::StopId> bus_stops(route.begin(), route.end());
+
+    router::RoutingSettings settings{6, 40};
+    settings.graph_model = router::GraphModel::ROUTE_STOPS;
+    router::TransportRouter route_stops(catalogue, settings);
+    vector<double> distances;
+    for (const graph::EdgeId edge_id : route_stops.GetBusEdgeIds()[bus]) {
+        const auto &edge_info = route_stops.GetEdgesInfo().at(edge_id);
+        if (const auto *ride_edge = get_if<router::RideEdgeInfo>(&edge_info)) {
+            distances.push_back(ride_edge->distance);
+        }
+    }
+    ASSERT_EQ(distances.size() + 1, bus_stops.size());
+    for (size_t idx = 0; idx < distances.size(); ++idx) {
+        ASSERT_EQ(distances[idx],
+                  catalogue.GetDistanceBetweenStops(bus_stops[idx], bus_stops[idx + 1]));
+    }
+
+    settings.graph_model = router::GraphModel::STOP_PAIRS;
+    router::TransportRouter stop_pairs(catalogue, settings);
+    vector<int> span_counts;
+    for (size_t from = 0; from + 1 < bus_stops.size(); ++from) {
+        int span_count = 0;
+        for (size_t to = from + 1; to < bus_stops.size(); ++to) {
+            if (bus_stops[from] != bus_stops[to]) {
+                span_counts.push_back(++span_count);
+            }
+        }
+    }
+    const auto &edge_ids = stop_pairs.GetBusEdgeIds()[bus];
+    ASSERT_EQ(edge_ids.size(), span_counts.size());
+    for (size_t idx = 0; idx < edge_ids.size(); ++idx) {
+        const auto &bus_edge =
+            get<router::BusEdgeInfo>(stop_pairs.GetEdgesInfo().at(edge_ids[idx]));
+        ASSERT_EQ(bus_edge.name, "2"sv);
+        ASSERT_EQ(bus_edge.span_count, span_counts[idx]);
+    }
+
+    stop_pairs.RemoveBus("2"sv);
+    ASSERT_TRUE(stop_pairs.GetBusEdgeIds()[bus].empty());
+}
+
+TEST(TransportRouter, IncrementalUpdatesMatchRebuild) {
+    for (const auto mode : {router::RouterMode::ALL_PAIRS,
+                            router::RouterMode::CONTRACTION_HIERARCHIES,
+                            router::RouterMode::LANDMARKS, router::RouterMode::RAPTOR,
+                            router::RouterMode::HUB_LABELS, router::RouterMode::A_STAR}) {
+        for (const auto graph_model :
+             {router::GraphModel::STOP_PAIRS, router::GraphModel::ROUTE_STOPS}) {
+            for (const auto vertex_order :
+                 {router::VertexOrder::NAME, router::VertexOrder::CUTHILL_MCKEE}) {
+                router::RoutingSettings settings{6, 40};
+                settings.mode = mode;
+                settings.graph_model = graph_model;
+                settings.vertex_order = vertex_order;
+                settings.profiles = {{"peak"s, 10, 20}};
+                ExpectIncrementalMatchesRebuild(settings);
+            }
+        }
+    }
+}
+
+TEST(TransportRouter, SetRoutingSettingsMatchesRebuild) {
+    const auto catalogue = MakeCatalogue();
+    for (const auto mode : {router::RouterMode::ALL_PAIRS,
+                            router::RouterMode::CONTRACTION_HIERARCHIES,
+                            router::RouterMode::A_STAR, router::RouterMode::LANDMARKS,
+                            router::RouterMode::RAPTOR, router::RouterMode::HUB_LABELS}) {
+        for (const auto graph_model :
+             {router::GraphModel::STOP_PAIRS, router::GraphModel::ROUTE_STOPS}) {
+            router::RoutingSettings settings{6, 40};
+            settings.mode = mode;
+            settings.graph_model = graph_model;
+            router::TransportRouter reweighted(catalogue, settings);
+
+            settings.bus_wait_time = 2;
+            settings.bus_velocity = 25;
+            reweighted.SetRoutingSettings(settings);
+            const router::TransportRouter rebuilt(catalogue, settings);
+            const auto &rebuilt_graph = rebuilt.GetCsrGraph();
+            const auto &reweighted_graph = reweighted.GetCsrGraph();
+            ASSERT_EQ(rebuilt_graph.GetEdgeIds(), reweighted_graph.GetEdgeIds());
+            ASSERT_EQ(rebuilt_graph.GetWeights(), reweighted_graph.GetWeights());
+
+            for (const auto from : {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv}) {
+                for (const auto to : {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv}) {
+                    const auto expected = rebuilt.GetRouteInfo(from, to);
+                    const auto route = reweighted.GetRouteInfo(from, to);
+                    ASSERT_EQ(expected.has_value(), route.has_value());
+                    if (route) {
+                        ASSERT_NEAR(expected->first, route->first, 1e-9);
+                    }
+                }
+            }
+
+            settings.graph_model = graph_model == router::GraphModel::STOP_PAIRS
+                                       ? router::GraphModel::ROUTE_STOPS
+                                       : router::GraphModel::STOP_PAIRS;
+            ASSERT_THROW(reweighted.SetRoutingSettings(settings), invalid_argument);
+        }
+    }
+}
+
+TEST(TransportRouter, SetRoutingSettingsRestoresTheGraph) {
+    const auto catalogue = MakeCatalogue();
+    for (const auto graph_model :
+         {router::GraphModel::STOP_PAIRS, router::GraphModel::ROUTE_STOPS}) {
+        router::RoutingSettings settings{6, 40};
+        settings.mode = router::RouterMode::DIJKSTRA;
+        settings.graph_model = graph_model;
+        router::TransportRouter switched(catalogue, settings);
+
+        for (const auto mode : {router::RouterMode::ALL_PAIRS, router::RouterMode::LANDMARKS,
+                                router::RouterMode::CONTRACTION_HIERARCHIES}) {
+            settings.mode = mode;
+            switched.SetRoutingSettings(settings);
+            const router::TransportRouter rebuilt(catalogue, settings);
+            for (const auto from : {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv}) {
+                for (const auto to : {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv}) {
+                    const auto expected = rebuilt.GetRouteInfo(from, to);
+                    const auto route = switched.GetRouteInfo(from, to);
+                    ASSERT_EQ(expected.has_value(), route.has_value());
+                    if (route) {
+                        ASSERT_NEAR(expected->first, route->first, 1e-9);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(TransportRouter, SetRoutingSettingsKeepsUnchangedProfiles) {
+    const auto catalogue = MakeCatalogue();
+    router::RoutingSettings settings{6, 40};
+    settings.profiles = {{"peak"s, 10, 20}, {"night"s, 2, 60}};
+    router::TransportRouter reweighted(catalogue, settings);
+    const auto *peak_table = reweighted.GetRoutesInternalData("peak"sv);
+    ASSERT_NE(nullptr, peak_table);
+
+    settings.bus_wait_time = 2;
+    settings.profiles[1].bus_velocity = 30;
+    reweighted.SetRoutingSettings(settings);
+    ASSERT_EQ(peak_table, reweighted.GetRoutesInternalData("peak"sv));
+
+    const router::TransportRouter rebuilt(catalogue, settings);
+    for (const auto profile : {""sv, "peak"sv, "night"sv}) {
+        ASSERT_EQ(rebuilt.GetRoutesInternalData(profile)->weights,
+                  reweighted.GetRoutesInternalData(profile)->weights)
+            << profile;
+    }
+}
+
+TEST(TransportRouter, ProfilesMatchSeparateRouters) {
+    const auto catalogue = MakeCatalogue();
+    const vector<router::RoutingProfile> profiles = {{"peak"s, 10, 20}, {"night"s, 2, 60}};
+    for (const auto mode : {router::RouterMode::ALL_PAIRS,
+                            router::RouterMode::CONTRACTION_HIERARCHIES,
+                            router::RouterMode::A_STAR, router::RouterMode::LANDMARKS,
+                            router::RouterMode::RAPTOR, router::RouterMode::LAZY_ROWS,
+                            router::RouterMode::HUB_LABELS}) {
+        for (const auto graph_model :
+             {router::GraphModel::STOP_PAIRS, router::GraphModel::ROUTE_STOPS}) {
+            router::RoutingSettings settings{6, 40};
+            settings.mode = mode;
+            settings.graph_model = graph_model;
+            settings.profiles = profiles;
+            const router::TransportRouter shared(catalogue, settings);
+            ASSERT_FALSE(shared.GetRouteInfo("A"sv, "D"sv, "unknown"sv));
+
+            for (const auto &profile : profiles) {
+                router::RoutingSettings separate_settings = settings;
+                separate_settings.bus_wait_time = profile.bus_wait_time;
+                separate_settings.bus_velocity = profile.bus_velocity;
+                separate_settings.profiles.clear();
+                const router::TransportRouter separate(catalogue, separate_settings);
+
+                for (const auto from : {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv}) {
+                    for (const auto to : {"A"sv, "B"sv, "C"sv, "D"sv, "E"sv}) {
+                        const auto expected = separate.GetRouteInfo(from, to);
+                        const auto route = shared.GetRouteInfo(from, to, profile.name);
+                        ASSERT_EQ(expected.has_value(), route.has_value());
+                        if (!route) {
+                            continue;
+                        }
+                        ASSERT_NEAR(expected->first, route->first, 1e-9);
+                        double items_time = 0;
+                        for (const auto &item : route->second) {
+                            items_time += visit([](const auto &info) { return info.time; },
+                                                item);
+                        }
+                        ASSERT_NEAR(route->first, items_time, 1e-9);
+                    }
+                }
+                const auto times = shared.GetTravelTimes({"A"sv, "E"sv}, {"C"sv, "D"sv},
+                                                         profile.name);
+                const auto expected_times =
+                    separate.GetTravelTimes({"A"sv, "E"sv}, {"C"sv, "D"sv});
+                ASSERT_EQ(expected_times.size(), times.size());
+                for (size_t row = 0; row < times.size(); ++row) {
+                    for (size_t column = 0; column < times[row].size(); ++column) {
+                        ASSERT_NEAR(*expected_times[row][column], *times[row][column], 1e-9);
+                    }
+                }
+            }
+        }
+    }
+}